@@ -0,0 +1,274 @@
+/**
+ * ARC implementation
+ */
+#include <algorithm>
+#include <cassert>
+
+#include "buffer/arc_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+ARCReplacer<T>::ARCReplacer(size_t num_frames,
+                            std::function<page_id_t(const T &)> page_id_of,
+                            T base)
+    : capacity_(num_frames), page_id_of_(page_id_of), base_(base),
+      frames_(num_frames), p_(0), size_(0), b1_ghost_hits_(0),
+      b2_ghost_hits_(0) {}
+
+template <typename T> ARCReplacer<T>::~ARCReplacer() {}
+
+/*
+ * Record an access of value and make it evictable. A frame still holding the
+ * same page is a hit and moves to the front of T2, otherwise the page was
+ * just loaded: a ghost hit adapts p and goes to T2, anything else to T1
+ */
+template <typename T> void ARCReplacer<T>::Insert(const T &value) {
+  size_t slot = FrameSlot(value);
+  assert(slot < frames_.size());
+  page_id_t page_id = page_id_of_(value);
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+
+  // the first access of a page read ahead is handled like a fresh load
+  bool is_hit = frame.list != LIST_NONE && frame.page_id == page_id &&
+                !frame.prefetched;
+  frame.prefetched = false;
+  // a frame that was freed and reused without being a victim
+  if (!is_hit)
+    Unlink(frame);
+  if (!frame.in_replacer) {
+    frame.in_replacer = true;
+    size_++;
+  }
+  frame.value = value;
+  frame.page_id = page_id;
+
+  if (is_hit) {
+    Unlink(frame);
+  } else if (RemoveGhost(b1_, page_id)) {
+    b1_ghost_hits_++;
+    size_t delta = std::max<size_t>(b2_.pages.size() / (b1_.pages.size() + 1), 1);
+    p_ = std::min(p_ + delta, capacity_);
+  } else if (RemoveGhost(b2_, page_id)) {
+    b2_ghost_hits_++;
+    size_t delta = std::max<size_t>(b1_.pages.size() / (b2_.pages.size() + 1), 1);
+    p_ = p_ > delta ? p_ - delta : 0;
+  } else {
+    t1_.push_front(slot);
+    frame.list = LIST_T1;
+    frame.position = t1_.begin();
+    return;
+  }
+  t2_.push_front(slot);
+  frame.list = LIST_T2;
+  frame.position = t2_.begin();
+}
+
+/*
+ * Make value evictable at the front of T1 without looking at the ghost lists,
+ * the page has not been accessed yet, see Insert
+ */
+template <typename T>
+void ARCReplacer<T>::InsertPrefetched(const T &value) {
+  size_t slot = FrameSlot(value);
+  assert(slot < frames_.size());
+  page_id_t page_id = page_id_of_(value);
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  Unlink(frame);
+  if (!frame.in_replacer) {
+    frame.in_replacer = true;
+    size_++;
+  }
+  frame.value = value;
+  frame.page_id = page_id;
+  frame.prefetched = true;
+  t1_.push_front(slot);
+  frame.list = LIST_T1;
+  frame.position = t1_.begin();
+}
+
+/*
+ * Evict the least recent evictable frame of T1 if T1 is above its target
+ * size p, otherwise of T2, and remember its page id in the matching ghost
+ * list. If no frame is evictable, return false
+ */
+template <typename T> bool ARCReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (size_ == 0)
+    return false;
+  if (t1_.size() > p_ || t2_.empty()) {
+    if (EvictFrom(t1_, b1_, value) || EvictFrom(t2_, b2_, value))
+      return true;
+  } else {
+    if (EvictFrom(t2_, b2_, value) || EvictFrom(t1_, b1_, value))
+      return true;
+  }
+  return false;
+}
+
+/*
+ * Replay Victim: T1 and T2 shrink by the frames taken from them, pinned
+ * frames stay in the lists
+ */
+template <typename T> std::vector<T> ARCReplacer<T>::GetEvictionOrder() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<T> order;
+  order.reserve(size_);
+  size_t t1_size = t1_.size();
+  size_t t2_size = t2_.size();
+  auto t1_it = t1_.rbegin();
+  auto t2_it = t2_.rbegin();
+  // skip to the next evictable frame towards the MRU end
+  auto next = [this](std::list<size_t>::reverse_iterator &it,
+                     std::list<size_t>::reverse_iterator end) {
+    while (it != end && !frames_[*it].in_replacer)
+      ++it;
+    return it != end;
+  };
+  while (true) {
+    bool t1_left = next(t1_it, t1_.rend());
+    bool t2_left = next(t2_it, t2_.rend());
+    if (!t1_left && !t2_left)
+      break;
+    bool from_t1 = t1_size > p_ || t2_size == 0 ? t1_left : !t2_left;
+    auto &it = from_t1 ? t1_it : t2_it;
+    order.push_back(frames_[*it].value);
+    ++it;
+    --(from_t1 ? t1_size : t2_size);
+  }
+  return order;
+}
+
+/*
+ * Make value non-evictable, it stays in T1/T2. If removal is successful,
+ * return true, otherwise return false
+ */
+template <typename T> bool ARCReplacer<T>::Erase(const T &value) {
+  size_t slot = FrameSlot(value);
+  if (slot >= frames_.size())
+    return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (!frame.in_replacer)
+    return false;
+  frame.in_replacer = false;
+  size_--;
+  return true;
+}
+
+template <typename T> size_t ARCReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
+
+template <typename T> ARCStatistics ARCReplacer<T>::GetStatistics() {
+  std::lock_guard<std::mutex> guard(latch_);
+  ARCStatistics stats;
+  stats.target_t1_size = p_;
+  stats.t1_size = t1_.size();
+  stats.t2_size = t2_.size();
+  stats.b1_size = b1_.pages.size();
+  stats.b2_size = b2_.pages.size();
+  stats.b1_ghost_hits = b1_ghost_hits_;
+  stats.b2_ghost_hits = b2_ghost_hits_;
+  return stats;
+}
+
+template <typename T> void ARCReplacer<T>::SetCapacity(size_t capacity) {
+  assert(capacity <= frames_.size());
+  std::lock_guard<std::mutex> guard(latch_);
+  capacity_ = capacity;
+  p_ = std::min(p_, capacity_);
+  TrimGhosts();
+}
+
+/*
+ * Private helper: evict the least recent evictable frame of list and add its
+ * page id to ghost. Caller must hold latch_
+ */
+template <typename T>
+bool ARCReplacer<T>::EvictFrom(std::list<size_t> &list, GhostList &ghost,
+                               T &value) {
+  for (auto it = list.rbegin(); it != list.rend(); ++it) {
+    Frame &frame = frames_[*it];
+    if (!frame.in_replacer)
+      continue;
+    page_id_t page_id = frame.page_id;
+    Unlink(frame);
+    frame.in_replacer = false;
+    // never accessed, not worth remembering
+    if (frame.prefetched)
+      page_id = INVALID_PAGE_ID;
+    frame.prefetched = false;
+    frame.page_id = INVALID_PAGE_ID;
+    AddGhost(ghost, page_id);
+    size_--;
+    value = frame.value;
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Private helper: take frame out of T1/T2. Caller must hold latch_
+ */
+template <typename T> void ARCReplacer<T>::Unlink(Frame &frame) {
+  if (frame.list == LIST_T1)
+    t1_.erase(frame.position);
+  else if (frame.list == LIST_T2)
+    t2_.erase(frame.position);
+  frame.list = LIST_NONE;
+}
+
+/*
+ * Private helper: remember page_id in ghost. Caller must hold latch_
+ */
+template <typename T>
+void ARCReplacer<T>::AddGhost(GhostList &ghost, page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID)
+    return;
+  ghost.pages.push_front(page_id);
+  ghost.index[page_id] = ghost.pages.begin();
+  TrimGhosts();
+}
+
+/*
+ * Private helper: keep the directory bounded, |T1| + |B1| <= c and
+ * |T1| + |T2| + |B1| + |B2| <= 2c, as far as the ghost lists allow. Caller
+ * must hold latch_
+ */
+template <typename T> void ARCReplacer<T>::TrimGhosts() {
+  while (t1_.size() + b1_.pages.size() > capacity_ && !b1_.pages.empty()) {
+    b1_.index.erase(b1_.pages.back());
+    b1_.pages.pop_back();
+  }
+  while (t1_.size() + t2_.size() + b1_.pages.size() + b2_.pages.size() >
+             2 * capacity_ &&
+         !(b1_.pages.empty() && b2_.pages.empty())) {
+    GhostList &victim = b2_.pages.empty() ? b1_ : b2_;
+    victim.index.erase(victim.pages.back());
+    victim.pages.pop_back();
+  }
+}
+
+/*
+ * Private helper: forget page_id if it is in ghost. Caller must hold latch_
+ */
+template <typename T>
+bool ARCReplacer<T>::RemoveGhost(GhostList &ghost, page_id_t page_id) {
+  auto it = ghost.index.find(page_id);
+  if (it == ghost.index.end())
+    return false;
+  ghost.pages.erase(it->second);
+  ghost.index.erase(it);
+  return true;
+}
+
+template class ARCReplacer<Page *>;
+// test only
+template class ARCReplacer<int>;
+
+} // namespace cmudb
@@ -1,36 +1,115 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <new>
+#include <sys/mman.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_ring.h"
+#include "common/exception.h"
 
 namespace cmudb {
 
 /*
  * BufferPoolManager Constructor
- * WARNING: Do Not Edit This Function
+ * num_instances: number of independent partitions the frames are split into,
+ * 1 keeps the classic single-latch buffer pool
+ * replacer_type: replacement policy used by every instance
+ * max_pool_size: number of frames ResizePool can grow the pool to, 0 for
+ * pool_size
+ * numa_mode: how the instances are placed on NUMA nodes, see numa_topology.h
+ * io_mode: whether the database file goes through the kernel page cache, or
+ * is mapped read-only
+ * compression: how the pages are stored in the database file, see
+ * disk_manager.h
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
-                                                 const std::string &db_file)
-    : pool_size_(pool_size), disk_manager_{db_file} {
-  // a consecutive memory space for buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(100);
-  replacer_ = new LRUReplacer<Page *>;
-  free_list_ = new std::list<Page *>;
+                                     const std::string &db_file,
+                                     size_t num_instances,
+                                     ReplacerType replacer_type,
+                                     size_t max_pool_size,
+                                     NumaMode numa_mode, DiskIOMode io_mode,
+                                     DiskCompression compression)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      num_instances_(num_instances), replacer_type_(replacer_type),
+      numa_(numa_mode), frame_arena_(max_pool_size_),
+      disk_manager_(db_file, ASYNC_IO_AUTO, io_mode, compression) {
+  assert(num_instances_ > 0 && num_instances_ <= pool_size_);
+  // a consecutive memory space for the metadata of the whole budget, the
+  // kernel backs it with memory as the pages are constructed
+  void *metadata =
+      mmap(nullptr, max_pool_size_ * sizeof(Page), PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (metadata == MAP_FAILED)
+    throw std::bad_alloc();
+  pages_ = static_cast<Page *>(metadata);
+  instances_ = new BufferPoolInstance[num_instances_];
+
+  // hand out the frames as evenly as possible
+  Page *next = pages_;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    instance.max_pool_size_ = max_pool_size_ / num_instances_ +
+                              (i < max_pool_size_ % num_instances_ ? 1 : 0);
+    instance.pages_ = next;
+    instance.pool_size_ = 0;
+    instance.num_constructed_ = 0;
+    instance.page_table_ = new PageTable(instance.max_pool_size_);
+    instance.replacer_ = CreateReplacer(instance);
+    instance.free_list_ = new std::list<Page *>;
+    // bound before the first frame is touched
+    instance.node_ = i % numa_.GetNumNodes();
+    numa_.BindMemory(instance.pages_, instance.max_pool_size_ * sizeof(Page),
+                     instance.node_);
+    numa_.BindMemory(frame_arena_.GetFrame(instance.pages_ - pages_),
+                     instance.max_pool_size_ * PAGE_SIZE, instance.node_,
+                     frame_arena_.GetMappingPageSize());
 
-  // put all the pages into free list
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_->push_back(&pages_[i]);
+    GrowInstance(instance, pool_size_ / num_instances_ +
+                               (i < pool_size_ % num_instances_ ? 1 : 0));
+    next += instance.max_pool_size_;
   }
+  if (GetIOMode() == DISK_IO_MMAP)
+    mapped_pages_ =
+        new std::atomic<Page *>[disk_manager_.GetNumMappedPages()]();
 }
 
 /*
  * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
  */
 BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundWriter();
+  {
+    std::lock_guard<std::mutex> guard(prefetch_mutex_);
+    prefetch_running_ = false;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetch_thread_.joinable())
+    prefetch_thread_.join();
   FlushAllPages();
-  delete[] pages_;
-  delete page_table_;
-  delete replacer_;
-  delete free_list_;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    delete instance.page_table_;
+    delete instance.replacer_;
+    delete instance.free_list_;
+    for (size_t j = 0; j < instance.num_constructed_; ++j)
+      instance.pages_[j].~Page();
+  }
+  delete[] instances_;
+  munmap(pages_, max_pool_size_ * sizeof(Page));
+  if (mapped_pages_ != nullptr) {
+    for (size_t i = 0; i < disk_manager_.GetNumMappedPages(); ++i)
+      delete mapped_pages_[i].load();
+    delete[] mapped_pages_;
+  }
 }
 
 /**
@@ -43,8 +122,71 @@ BufferPoolManager::~BufferPoolManager() {
  * for the new page.
  * 4. Update page metadata, read page content from disk file and return page
  * pointer
+ * A hit is first tried without the instance latch, see TryPinPage. Pinned
+ * pages stay in the replacer and are skipped when chosen as victim. A miss
+ * claims its frame and reads the page with the latch released, a second miss
+ * of the same page meanwhile waits for that read.
+ * ring: if not nullptr, a miss recycles a frame of the ring instead
  */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) { return nullptr; }
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferRing *ring) {
+  if (page_id == INVALID_PAGE_ID)
+    return nullptr;
+  if (mapped_pages_ != nullptr)
+    return FetchMappedPage(page_id);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  RecordNodeAccess(instance);
+
+  Page *page = nullptr;
+  bool is_found = instance.page_table_->Find(page_id, page);
+  if (is_found && TryPinPage(instance, page, page_id)) {
+    RecordAccess(page_id, true);
+    return page;
+  }
+  if (is_found)
+    counters_.Add(BPM_COUNTER_PIN_WAITS);
+
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  WaitForRead(instance, lock, page_id);
+  // nobody evicts while we hold the latch, so the pin count is not negative
+  if (instance.page_table_->Find(page_id, page)) {
+    page->pin_count_++;
+    RecordAccess(page_id, true);
+    return page;
+  }
+
+  RecordAccess(page_id, false);
+  page = ring == nullptr ? GetVictimPage(instance)
+                         : GetRingVictimPage(instance, ring);
+  if (page == nullptr)
+    return nullptr;
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  // the frame keeps pin count -1 and stays out of the page table, so nobody
+  // else touches it while it is read
+  instance.reading_.insert(page_id);
+  lock.unlock();
+  try {
+    ReadIn(page_id, page);
+  } catch (PageCorruptionException &) {
+    // the frame goes back unused, the next fetch reads the page again
+    lock.lock();
+    instance.reading_.erase(page_id);
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_ring_frame_ = false;
+    instance.free_list_->push_back(page);
+    lock.unlock();
+    instance.io_cv_.notify_all();
+    throw;
+  }
+  lock.lock();
+  instance.reading_.erase(page_id);
+  // publish the frame only once its content is loaded
+  page->pin_count_ = 1;
+  instance.page_table_->Insert(page_id, page);
+  lock.unlock();
+  instance.io_cv_.notify_all();
+  return page;
+}
 
 /*
  * Implementation of unpin page
@@ -53,7 +195,58 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) { return nullptr; }
  * is_dirty: set the dirty flag of this page
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  return false;
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  if (mapped_pages_ != nullptr) {
+    if (disk_manager_.GetMappedPage(page_id) == nullptr)
+      return false;
+    Page *page = mapped_pages_[page_id];
+    return page != nullptr && UnpinMappedPage(page);
+  }
+  BufferPoolInstance &instance = GetInstance(page_id);
+
+  // the caller holds a pin, so the page cannot be evicted under us and the
+  // latch is only needed if the lock-free lookup misses
+  Page *page = nullptr;
+  bool found =
+      instance.page_table_->Find(page_id, page) && page->page_id_ == page_id;
+  if (!found) {
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    found = instance.page_table_->Find(page_id, page);
+  }
+  if (!found)
+    return false;
+  return UnpinFrame(instance, page, is_dirty);
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+                                               BufferRing *ring) {
+  Page *page = FetchPage(page_id, ring);
+  if (page == nullptr)
+    return ReadPageGuard();
+  page->RLock();
+  return ReadPageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id,
+                                                 BufferRing *ring) {
+  // the mapping cannot be written
+  if (mapped_pages_ != nullptr)
+    return WritePageGuard();
+  Page *page = FetchPage(page_id, ring);
+  if (page == nullptr)
+    return WritePageGuard();
+  page->WLock();
+  return WritePageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::NewPageWrite(page_id_t &page_id,
+                                               page_id_t near) {
+  Page *page = NewPage(page_id, near);
+  if (page == nullptr)
+    return WritePageGuard();
+  page->WLock();
+  return WritePageGuard(this, page, true);
 }
 
 /*
@@ -62,12 +255,68 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
  * if page is not found in page table, return false
  * NOTE: make sure page_id != INVALID_PAGE_ID
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) { return false; }
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::lock_guard<std::mutex> guard(instance.latch_);
+
+  Page *page = nullptr;
+  if (!instance.page_table_->Find(page_id, page))
+    return false;
+  if (page->is_dirty_) {
+    WriteBack(page_id, page);
+    page->is_dirty_ = false;
+  }
+  return true;
+}
 
 /*
- * Used to flush all dirty pages in the buffer pool manager
+ * Used to flush all dirty pages in the buffer pool manager. Consecutive
+ * pages live in different instances, so all of them are latched (in order)
+ * while the dirty pages are written in page id order, every run of
+ * consecutive pages with one vectored write. The runs are all submitted
+ * before the first one is waited for, and synced once at the end
  */
-void BufferPoolManager::FlushAllPages() {}
+void BufferPoolManager::FlushAllPages() {
+  std::vector<std::unique_lock<std::mutex>> guards;
+  std::vector<std::pair<page_id_t, Page *>> dirty_pages;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    guards.emplace_back(instance.latch_);
+    for (size_t j = 0; j < instance.pool_size_; ++j) {
+      Page *page = &instance.pages_[j];
+      if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_)
+        dirty_pages.emplace_back(page->page_id_, page);
+    }
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+  std::vector<const char *> run;
+  std::vector<std::future<bool>> writes;
+  for (size_t first = 0; first < dirty_pages.size(); first += run.size()) {
+    run.clear();
+    do {
+      Page *page = dirty_pages[first + run.size()].second;
+      // cleared first, a concurrent writer of the content sets it again
+      page->is_dirty_ = false;
+      run.push_back(page->GetData());
+    } while (first + run.size() < dirty_pages.size() &&
+             dirty_pages[first + run.size()].first ==
+                 dirty_pages[first].first + (page_id_t)run.size());
+    // run is only read until the call returns
+    writes.push_back(disk_manager_.WritePagesAsync(dirty_pages[first].first,
+                                                   run.data(), run.size()));
+    counters_.Add(BPM_COUNTER_DIRTY_WRITEBACKS, run.size());
+  }
+  for (auto &write : writes)
+    write.wait();
+  disk_manager_.Sync();
+  guards.clear();
+
+  std::lock_guard<std::mutex> guard(warm_up_mutex_);
+  if (!warm_up_file_.empty())
+    SaveWarmUpFile(warm_up_file_);
+}
 
 /**
  * User should call this method for deleting a page. This routine will call disk
@@ -78,7 +327,31 @@ void BufferPoolManager::FlushAllPages() {}
  * method to delete from disk file.
  * If the page is found within page table, but pin_count != 0, return false
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id) { return false; }
+bool BufferPoolManager::DeletePage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID || mapped_pages_ != nullptr)
+    return false;
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  WaitForRead(instance, lock, page_id);
+
+  Page *page = nullptr;
+  if (instance.page_table_->Find(page_id, page)) {
+    // claim the frame so that lock-free readers cannot pin it any more
+    int unpinned = 0;
+    if (!page->pin_count_.compare_exchange_strong(unpinned, -1))
+      return false;
+    instance.page_table_->Remove(page_id);
+    instance.replacer_->Erase(page);
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    page->is_ring_frame_ = false;
+    page->ResetMemory();
+    instance.free_list_->push_back(page);
+  }
+  compressed_cache_.Erase(page_id);
+  disk_manager_.DeallocatePage(page_id);
+  return true;
+}
 
 /**
  * User should call this method if needs to create a new page. This routine
@@ -89,5 +362,846 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) { return false; }
  * table.
  * return nullptr is all the pages in pool are pinned
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) { return nullptr; }
+Page *BufferPoolManager::NewPage(page_id_t &page_id, page_id_t near) {
+  if (mapped_pages_ != nullptr)
+    return nullptr;
+  // the page id decides which instance has to host the page, so allocate
+  // first and give the id back if that instance is fully pinned
+  page_id_t new_page_id = numa_.GetMode() == NUMA_MODE_OFF
+                              ? disk_manager_.AllocatePage(near)
+                              : AllocateLocalPageId(near);
+  BufferPoolInstance &instance = GetInstance(new_page_id);
+  RecordNodeAccess(instance);
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  WaitForRead(instance, lock, new_page_id);
+
+  // a read-ahead that raced with the allocation may have cached whatever the
+  // file held for this page id, take over its frame
+  Page *page = nullptr;
+  int unpinned = 0;
+  if (instance.page_table_->Find(new_page_id, page) &&
+      page->pin_count_.compare_exchange_strong(unpinned, -1)) {
+    instance.page_table_->Remove(new_page_id);
+    instance.replacer_->Erase(page);
+  } else {
+    page = GetVictimPage(instance);
+  }
+  if (page == nullptr) {
+    disk_manager_.DeallocatePage(new_page_id);
+    return nullptr;
+  }
+  page_id = new_page_id;
+  page->ResetMemory();
+  page->page_id_ = page_id;
+  // the page does not exist on disk yet, make sure it gets written
+  page->is_dirty_ = true;
+  page->pin_count_ = 1;
+  instance.page_table_->Insert(page_id, page);
+  return page;
+}
+
+/*
+ * Resize the pool, see header
+ */
+bool BufferPoolManager::ResizePool(size_t pool_size) {
+  if (pool_size < num_instances_ || pool_size > max_pool_size_)
+    return false;
+  std::lock_guard<std::mutex> resize_guard(resize_mutex_);
+  bool is_resized = true;
+  size_t new_pool_size = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    size_t instance_pool_size =
+        pool_size / num_instances_ + (i < pool_size % num_instances_ ? 1 : 0);
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    if (instance_pool_size > instance.pool_size_)
+      GrowInstance(instance, instance_pool_size);
+    else if (instance_pool_size < instance.pool_size_)
+      is_resized = ShrinkInstance(instance, instance_pool_size) && is_resized;
+    new_pool_size += instance.pool_size_;
+  }
+  pool_size_ = new_pool_size;
+  return is_resized;
+}
+
+/*
+ * Sum the adaptation counters of every instance's ARC replacer
+ */
+ARCStatistics BufferPoolManager::GetARCStatistics() {
+  ARCStatistics total;
+  if (replacer_type_ != REPLACER_TYPE_ARC)
+    return total;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    ARCStatistics stats =
+        static_cast<ARCReplacer<Page *> *>(instances_[i].replacer_)
+            ->GetStatistics();
+    total.target_t1_size += stats.target_t1_size;
+    total.t1_size += stats.t1_size;
+    total.t2_size += stats.t2_size;
+    total.b1_size += stats.b1_size;
+    total.b2_size += stats.b2_size;
+    total.b1_ghost_hits += stats.b1_ghost_hits;
+    total.b2_ghost_hits += stats.b2_ghost_hits;
+  }
+  return total;
+}
+
+/*
+ * Sum the per-core counters, see buffer_pool_stats.h
+ */
+BufferPoolStatistics BufferPoolManager::GetStatistics() {
+  return counters_.Snapshot();
+}
+
+void BufferPoolManager::ResetStatistics() {
+  counters_.Reset();
+  page_heat_.Reset();
+  compressed_cache_.ResetStatistics();
+}
+
+/*
+ * Turn the per page access counters on or off, the counts collected so far
+ * are kept
+ */
+void BufferPoolManager::SetPageHeatTracking(bool enabled) {
+  track_page_heat_ = enabled;
+}
+
+std::vector<std::pair<page_id_t, uint64_t>>
+BufferPoolManager::GetPageHeat(size_t limit) {
+  return page_heat_.Snapshot(limit);
+}
+
+void BufferPoolManager::SetCompressedCacheCapacity(size_t capacity) {
+  compressed_cache_.SetCapacity(capacity);
+}
+
+CompressedCacheStatistics BufferPoolManager::GetCompressedCacheStatistics() {
+  return compressed_cache_.GetStatistics();
+}
+
+/*
+ * Start the background writer thread, see header. Does nothing if it is
+ * already running
+ */
+void BufferPoolManager::StartBackgroundWriter(double low_watermark,
+                                              double high_watermark,
+                                              int interval_ms) {
+  assert(0 <= low_watermark && low_watermark <= high_watermark &&
+         high_watermark <= 1);
+  std::lock_guard<std::mutex> guard(writer_mutex_);
+  if (writer_running_)
+    return;
+  low_watermark_ = low_watermark;
+  high_watermark_ = high_watermark;
+  writer_interval_ms_ = interval_ms;
+  writer_running_ = true;
+  writer_thread_ = std::thread(&BufferPoolManager::BackgroundWriterLoop, this);
+}
+
+/*
+ * Stop the background writer thread and wait for its current round to end
+ */
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    if (!writer_running_)
+      return;
+    writer_running_ = false;
+  }
+  writer_cv_.notify_one();
+  writer_thread_.join();
+}
+
+/*
+ * Queue pages for read-ahead, see header. The prefetch thread is started on
+ * first use
+ */
+void BufferPoolManager::PrefetchPages(page_id_t first_page_id,
+                                      size_t num_pages) {
+  if (first_page_id == INVALID_PAGE_ID || num_pages == 0)
+    return;
+  // the kernel reads the mapping ahead by itself
+  if (mapped_pages_ != nullptr) {
+    disk_manager_.AdvisePages(first_page_id, num_pages, DISK_ADVICE_WILLNEED);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(prefetch_mutex_);
+    if (!prefetch_running_) {
+      prefetch_running_ = true;
+      prefetch_thread_ = std::thread(&BufferPoolManager::PrefetchLoop, this);
+    }
+    // more pages than the pool holds would evict each other before use
+    for (size_t i = 0; i < num_pages && prefetch_queue_.size() < pool_size_;
+         ++i)
+      prefetch_queue_.push_back(first_page_id + i);
+  }
+  prefetch_cv_.notify_all();
+}
+
+void BufferPoolManager::AdvisePages(page_id_t first_page_id,
+                                    size_t num_pages, DiskAdvice advice) {
+  disk_manager_.AdvisePages(first_page_id, num_pages, advice);
+}
+
+void BufferPoolManager::WaitForPrefetches() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  prefetch_cv_.wait(lock,
+                    [this] { return prefetch_queue_.empty() && !prefetch_busy_; });
+}
+
+/*
+ * Rank the cached pages of every instance, then interleave the rankings so
+ * that no instance is favoured
+ */
+std::vector<page_id_t> BufferPoolManager::GetResidentPages() {
+  std::vector<std::vector<page_id_t>> ranks(num_instances_);
+  size_t longest = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    std::vector<page_id_t> &rank = ranks[i];
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    for (size_t j = 0; j < instance.pool_size_; ++j) {
+      Page *page = &instance.pages_[j];
+      if (page->page_id_ != INVALID_PAGE_ID && page->pin_count_ > 0 &&
+          !page->is_ring_frame_)
+        rank.push_back(page->page_id_);
+    }
+    // pinned pages and stale entries of deleted pages may still be in there
+    std::vector<Page *> order = instance.replacer_->GetEvictionOrder();
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+      Page *page = *it;
+      if (page->page_id_ != INVALID_PAGE_ID && page->pin_count_ == 0 &&
+          !page->is_ring_frame_)
+        rank.push_back(page->page_id_);
+    }
+    longest = std::max(longest, rank.size());
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t j = 0; j < longest; ++j) {
+    for (auto &rank : ranks) {
+      if (j < rank.size())
+        page_ids.push_back(rank[j]);
+    }
+  }
+  return page_ids;
+}
+
+/*
+ * The file is written next to its final name and renamed, so a crash leaves
+ * either the old or the new list
+ */
+bool BufferPoolManager::SaveWarmUpFile(const std::string &file_name) {
+  std::vector<page_id_t> page_ids = GetResidentPages();
+  std::string temp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(temp_file_name, std::ios::trunc);
+    for (page_id_t page_id : page_ids)
+      out << page_id << '\n';
+    if (!out.good())
+      return false;
+  }
+  return rename(temp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+/*
+ * Pick the pages that fit into the free frames of their instance in the
+ * order listed, read them in page id order, consecutive pages with a single
+ * read of up to WARM_UP_READ_PAGES pages, and finally hand them to the
+ * replacers least worth keeping first
+ */
+size_t BufferPoolManager::LoadWarmUpFile(const std::string &file_name) {
+  std::ifstream in(file_name);
+  // the frames are not used with a mapped file
+  if (!in.is_open() || mapped_pages_ != nullptr)
+    return 0;
+  std::vector<size_t> free_frames(num_instances_);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    std::lock_guard<std::mutex> guard(instances_[i].latch_);
+    free_frames[i] = instances_[i].free_list_->size();
+  }
+  // pages past the end of the file were never written
+  page_id_t num_pages = disk_manager_.GetNumPages();
+  std::vector<page_id_t> ranked;
+  std::unordered_set<page_id_t> listed;
+  page_id_t page_id;
+  while (in >> page_id) {
+    if (page_id < 0 || page_id >= num_pages || !listed.insert(page_id).second)
+      continue;
+    size_t &free = free_frames[page_id % num_instances_];
+    if (free == 0)
+      continue;
+    free--;
+    ranked.push_back(page_id);
+  }
+
+  std::vector<page_id_t> sorted(ranked);
+  std::sort(sorted.begin(), sorted.end());
+  std::vector<char> buffer(WARM_UP_READ_PAGES * PAGE_SIZE);
+  std::unordered_map<page_id_t, Page *> loaded;
+  for (size_t first = 0; first < sorted.size();) {
+    size_t num_pages = 1;
+    while (first + num_pages < sorted.size() &&
+           num_pages < WARM_UP_READ_PAGES &&
+           sorted[first + num_pages] == sorted[first] + (page_id_t)num_pages)
+      num_pages++;
+    try {
+      disk_manager_.ReadPages(sorted[first], num_pages, buffer.data());
+    } catch (PageCorruptionException &) {
+      // left to the fetch that needs the damaged page to report
+      first += num_pages;
+      continue;
+    }
+    for (size_t i = 0; i < num_pages; ++i) {
+      Page *page =
+          LoadWarmUpPage(sorted[first + i], buffer.data() + i * PAGE_SIZE);
+      if (page != nullptr)
+        loaded[sorted[first + i]] = page;
+    }
+    first += num_pages;
+  }
+
+  for (auto it = ranked.rbegin(); it != ranked.rend(); ++it) {
+    auto entry = loaded.find(*it);
+    if (entry == loaded.end())
+      continue;
+    BufferPoolInstance &instance = GetInstance(*it);
+    Page *page = entry->second;
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    // a pinned page enters the replacer when it is unpinned
+    if (page->page_id_ == *it && page->pin_count_ == 0)
+      instance.replacer_->Insert(page);
+  }
+  return loaded.size();
+}
+
+void BufferPoolManager::SetWarmUpFile(const std::string &file_name) {
+  std::lock_guard<std::mutex> guard(warm_up_mutex_);
+  warm_up_file_ = file_name;
+}
+
+/*
+ * Private helper: body of the prefetch thread
+ */
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] {
+      return !prefetch_running_ || !prefetch_queue_.empty();
+    });
+    if (!prefetch_running_)
+      break;
+    std::vector<page_id_t> page_ids;
+    while (!prefetch_queue_.empty() && page_ids.size() < ASYNC_IO_QUEUE_DEPTH) {
+      page_ids.push_back(prefetch_queue_.front());
+      prefetch_queue_.pop_front();
+    }
+    prefetch_busy_ = true;
+    lock.unlock();
+    PrefetchBatch(page_ids);
+    lock.lock();
+    prefetch_busy_ = false;
+    // wake up WaitForPrefetches
+    prefetch_cv_.notify_all();
+  }
+  prefetch_queue_.clear();
+  prefetch_cv_.notify_all();
+}
+
+/*
+ * Private helper: load the pages into frames like FetchPage misses, but leave
+ * them unpinned in the replacer without counting as accesses. Frames are
+ * claimed for all of them first, then all reads are submitted at once
+ */
+void BufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids) {
+  // reading past the end of the file would cache garbage
+  page_id_t num_pages = disk_manager_.GetNumPages();
+  std::vector<std::pair<page_id_t, Page *>> claimed;
+  std::vector<std::future<bool>> reads;
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= num_pages)
+      continue;
+    BufferPoolInstance &instance = GetInstance(page_id);
+    Page *page = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(instance.latch_);
+      if (instance.reading_.count(page_id) != 0 ||
+          instance.page_table_->Find(page_id, page))
+        continue;
+      page = GetVictimPage(instance);
+      if (page == nullptr)
+        continue;
+      page->page_id_ = page_id;
+      page->is_dirty_ = false;
+      instance.reading_.insert(page_id);
+    }
+    claimed.emplace_back(page_id, page);
+    std::promise<bool> cached;
+    if (compressed_cache_.Take(page_id, page->GetData())) {
+      cached.set_value(true);
+      reads.push_back(cached.get_future());
+    } else {
+      reads.push_back(disk_manager_.ReadPageAsync(page_id, page->GetData()));
+    }
+  }
+
+  for (size_t i = 0; i < claimed.size(); ++i) {
+    page_id_t page_id = claimed[i].first;
+    Page *page = claimed[i].second;
+    bool is_read = reads[i].get();
+    BufferPoolInstance &instance = GetInstance(page_id);
+    {
+      std::lock_guard<std::mutex> guard(instance.latch_);
+      instance.reading_.erase(page_id);
+      if (is_read) {
+        page->pin_count_ = 0;
+        // into the replacer before lock-free readers can find and pin it
+        instance.replacer_->InsertPrefetched(page);
+        instance.page_table_->Insert(page_id, page);
+      } else {
+        page->page_id_ = INVALID_PAGE_ID;
+        instance.free_list_->push_back(page);
+      }
+    }
+    instance.io_cv_.notify_all();
+  }
+}
+
+/*
+ * Private helper: cache page_id with content data in a free frame, unpinned
+ * and not in the replacer yet. return nullptr if the page is cached already
+ * or the instance has no free frame left
+ */
+Page *BufferPoolManager::LoadWarmUpPage(page_id_t page_id, const char *data) {
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::lock_guard<std::mutex> guard(instance.latch_);
+  Page *page = nullptr;
+  if (instance.page_table_->Find(page_id, page) ||
+      instance.reading_.count(page_id) != 0 || instance.free_list_->empty())
+    return nullptr;
+  page = instance.free_list_->front();
+  instance.free_list_->pop_front();
+  page->is_ring_frame_ = false;
+  // no page is cached by both tiers
+  compressed_cache_.Erase(page_id);
+  memcpy(page->GetData(), data, PAGE_SIZE);
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  page->pin_count_ = 0;
+  instance.page_table_->Insert(page_id, page);
+  return page;
+}
+
+/*
+ * Private helper: body of the background writer thread
+ */
+void BufferPoolManager::BackgroundWriterLoop() {
+  std::unique_lock<std::mutex> lock(writer_mutex_);
+  while (writer_running_) {
+    writer_cv_.wait_for(lock, std::chrono::milliseconds(writer_interval_ms_),
+                        [this] { return !writer_running_ || writer_wakeup_; });
+    if (!writer_running_)
+      break;
+    writer_wakeup_ = false;
+    lock.unlock();
+    WriteBackDirtyPages();
+    lock.lock();
+  }
+}
+
+/*
+ * Private helper: one round of the background writer. Counts the clean
+ * evictable frames (free, or unpinned and clean) and, if they are below the
+ * low watermark, writes dirty unpinned pages in page id order until the high
+ * watermark is reached
+ */
+void BufferPoolManager::WriteBackDirtyPages() {
+  size_t num_clean = 0;
+  std::vector<std::pair<page_id_t, Page *>> candidates;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    num_clean += instance.free_list_->size();
+    for (size_t j = 0; j < instance.pool_size_; ++j) {
+      Page *page = &instance.pages_[j];
+      if (page->pin_count_ != 0)
+        continue;
+      if (page->is_dirty_)
+        candidates.emplace_back(page->page_id_, page);
+      else
+        num_clean++;
+    }
+  }
+  if (num_clean >= low_watermark_ * pool_size_)
+    return;
+
+  // sequential I/O for the disk
+  std::sort(candidates.begin(), candidates.end());
+  size_t target = static_cast<size_t>(high_watermark_ * pool_size_);
+  for (auto &candidate : candidates) {
+    if (num_clean >= target)
+      break;
+    page_id_t page_id = candidate.first;
+    Page *page = candidate.second;
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    // the frame may have been pinned or recycled since it was collected
+    if (page->page_id_ != page_id || page->pin_count_ != 0 || !page->is_dirty_)
+      continue;
+    // cleared first, a concurrent writer of the content sets it again
+    page->is_dirty_ = false;
+    WriteBack(page_id, page);
+    num_clean++;
+  }
+}
+
+/*
+ * Private helper: write the content of page back to disk as page_id, the
+ * caller clears the dirty flag
+ */
+void BufferPoolManager::WriteBack(page_id_t page_id, Page *page) {
+  disk_manager_.WritePage(page_id, page->GetData());
+  counters_.Add(BPM_COUNTER_DIRTY_WRITEBACKS);
+}
+
+/*
+ * Private helper: allocate a page id of an instance on the calling thread's
+ * node. Ids of other nodes are set aside for their threads. A node without
+ * local instances, or one that creates far more pages than the others,
+ * takes the oldest spare id once NUMA_SPARE_PAGE_IDS of them piled up, so
+ * at most that many ids are held back
+ */
+page_id_t BufferPoolManager::AllocateLocalPageId(page_id_t near) {
+  size_t node = numa_.GetCurrentNode();
+  std::lock_guard<std::mutex> guard(spare_page_ids_mutex_);
+  for (auto it = spare_page_ids_.begin(); it != spare_page_ids_.end(); ++it) {
+    if (GetInstance(*it).node_ == node) {
+      page_id_t page_id = *it;
+      spare_page_ids_.erase(it);
+      return page_id;
+    }
+  }
+  while (spare_page_ids_.size() < NUMA_SPARE_PAGE_IDS) {
+    page_id_t page_id = disk_manager_.AllocatePage(near);
+    if (GetInstance(page_id).node_ == node)
+      return page_id;
+    spare_page_ids_.push_back(page_id);
+  }
+  page_id_t page_id = spare_page_ids_.front();
+  spare_page_ids_.pop_front();
+  return page_id;
+}
+
+/*
+ * Private helper: pin the Page of page_id in the mapped file, creating it on
+ * first use. return nullptr past the end of the mapping, throw
+ * PageCorruptionException if the page fails its checksum
+ */
+Page *BufferPoolManager::FetchMappedPage(page_id_t page_id) {
+  const char *data = disk_manager_.GetMappedPage(page_id);
+  if (data == nullptr)
+    return nullptr;
+  Page *page = mapped_pages_[page_id].load();
+  if (page == nullptr) {
+    // checked once, when the page is first touched
+    if (!DiskManager::VerifyChecksum(data))
+      throw PageCorruptionException(page_id, "fails its checksum");
+    Page *created = new Page();
+    created->data_ = const_cast<char *>(data);
+    created->page_id_ = page_id;
+    // another fetch may have been first
+    if (mapped_pages_[page_id].compare_exchange_strong(page, created)) {
+      page = created;
+    } else {
+      delete created;
+    }
+  }
+  page->pin_count_++;
+  // served without I/O of the pool, whether the kernel had the page or not
+  RecordAccess(page_id, true);
+  return page;
+}
+
+/*
+ * Private helper: drop one pin of a Page of the mapped file, which has no
+ * replacer and cannot be dirty. return false if page was not pinned
+ */
+bool BufferPoolManager::UnpinMappedPage(Page *page) {
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count <= 0)
+      return false;
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  return true;
+}
+
+/*
+ * Private helper: load the content of page_id into the frame of page, from
+ * the compressed page cache if it has the page, otherwise from disk
+ */
+void BufferPoolManager::ReadIn(page_id_t page_id, Page *page) {
+  if (!compressed_cache_.Take(page_id, page->GetData()))
+    disk_manager_.ReadPage(page_id, page->GetData());
+}
+
+/*
+ * Private helper: take a frame from the free list, or evict an unpinned page
+ * chosen by the replacer, writing it back if dirty and dropping its page table
+ * entry. Frames that are free or being evicted have pin count -1, so
+ * lock-free readers cannot pin them, the caller publishes the returned frame
+ * by setting the pin count. Caller must hold instance.latch_
+ * return nullptr if all the pages of the instance are pinned
+ */
+Page *BufferPoolManager::GetVictimPage(BufferPoolInstance &instance) {
+  Page *page = nullptr;
+  if (!instance.free_list_->empty()) {
+    page = instance.free_list_->front();
+    instance.free_list_->pop_front();
+    page->is_ring_frame_ = false;
+    return page;
+  }
+  counters_.Add(BPM_COUNTER_FREE_LIST_EMPTY);
+  while (instance.replacer_->Victim(page)) {
+    // pinned by a lock-free hit (it goes back to the replacer on unpin), or a
+    // stale entry of a deleted page whose frame sits in the free list
+    int unpinned = 0;
+    if (!page->pin_count_.compare_exchange_strong(unpinned, -1))
+      continue;
+    if (page->is_dirty_) {
+      WriteBack(page->page_id_, page);
+      page->is_dirty_ = false;
+      // the background writer, if any, is falling behind
+      {
+        std::lock_guard<std::mutex> guard(writer_mutex_);
+        writer_wakeup_ = true;
+      }
+      writer_cv_.notify_one();
+    }
+    // clean now, pages of scans are not worth a second chance
+    if (!page->is_ring_frame_)
+      compressed_cache_.Insert(page->page_id_, page->GetData());
+    instance.page_table_->Remove(page->page_id_);
+    counters_.Add(BPM_COUNTER_EVICTIONS);
+    // a ring frame that slipped into the replacer, see ReleaseRingFrame
+    page->is_ring_frame_ = false;
+    return page;
+  }
+  return nullptr;
+}
+
+/*
+ * Private helper: like GetVictimPage, but take the frame from the next slot
+ * of ring. If the slot is empty, or its frame is pinned or no longer owned by
+ * the ring, a regular victim takes its place. Caller must hold
+ * instance.latch_
+ * return nullptr if all the pages of the instance are pinned
+ */
+Page *BufferPoolManager::GetRingVictimPage(BufferPoolInstance &instance,
+                                           BufferRing *ring) {
+  BufferRing::Slots &slots = ring->slots_[&instance - instances_];
+  Page *&slot = slots.frames[slots.next];
+  slots.next = (slots.next + 1) % slots.frames.size();
+
+  if (slot != nullptr) {
+    int unpinned = 0;
+    if (slot->is_ring_frame_ &&
+        slot->pin_count_.compare_exchange_strong(unpinned, -1)) {
+      Page *page = slot;
+      // in case ReleaseRingFrame and UnpinPage both inserted it
+      instance.replacer_->Erase(page);
+      if (page->is_dirty_) {
+        WriteBack(page->page_id_, page);
+        page->is_dirty_ = false;
+      }
+      instance.page_table_->Remove(page->page_id_);
+      counters_.Add(BPM_COUNTER_EVICTIONS);
+      return page;
+    }
+    ReleaseRingFrame(instance, slot);
+    slot = nullptr;
+  }
+  Page *page = GetVictimPage(instance);
+  if (page != nullptr) {
+    page->is_ring_frame_ = true;
+    slot = page;
+  }
+  return page;
+}
+
+/*
+ * Private helper: hand a frame of a ring back to the shared replacer. Pairs
+ * with UnpinPage, which releases the pin before it looks at the flag, while
+ * this clears the flag before it looks at the pin count, so an unpinned
+ * frame is inserted at least once. Caller must hold instance.latch_
+ */
+void BufferPoolManager::ReleaseRingFrame(BufferPoolInstance &instance,
+                                         Page *page) {
+  if (!page->is_ring_frame_.exchange(false))
+    return;
+  if (page->pin_count_ == 0)
+    instance.replacer_->Insert(page);
+}
+
+/*
+ * Private helper: hand all frames of ring back, called by its destructor
+ */
+void BufferPoolManager::ReleaseBufferRing(BufferRing *ring) {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    std::lock_guard<std::mutex> guard(instance.latch_);
+    for (Page *page : ring->slots_[i].frames) {
+      if (page != nullptr)
+        ReleaseRingFrame(instance, page);
+    }
+  }
+}
+
+/*
+ * Private helper: give back the pin of a guard. The guard holds the page
+ * pinned, so its frame is still the one the page id maps to
+ */
+void BufferPoolManager::ReleasePage(Page *page, bool is_dirty) {
+  if (mapped_pages_ != nullptr)
+    UnpinMappedPage(page);
+  else
+    UnpinFrame(GetInstance(page->page_id_), page, is_dirty);
+}
+
+/*
+ * Private helper: drop one pin of page, it goes back to the replacer with the
+ * last one. return false if page was not pinned
+ */
+bool BufferPoolManager::UnpinFrame(BufferPoolInstance &instance, Page *page,
+                                   bool is_dirty) {
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count <= 0)
+      return false;
+    // set before the pin is released, never clear a flag set by another user
+    if (is_dirty)
+      page->is_dirty_ = true;
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  // checked after the pin is released, see ReleaseRingFrame
+  if (pin_count == 1 && !page->is_ring_frame_)
+    instance.replacer_->Insert(page);
+  return true;
+}
+
+/*
+ * Private helper: pin page for page_id without the instance latch. Fails if
+ * the frame is being evicted or no longer holds page_id, the caller then
+ * retries under the latch
+ */
+bool BufferPoolManager::TryPinPage(BufferPoolInstance &instance, Page *page,
+                                   page_id_t page_id) {
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count < 0)
+      return false;
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  // the frame may have been recycled between the lookup and the pin
+  if (page->page_id_ == page_id)
+    return true;
+  if (page->pin_count_.fetch_sub(1) == 1 && !page->is_ring_frame_)
+    instance.replacer_->Insert(page);
+  return false;
+}
+
+/*
+ * Private helper: build the replacer of one instance according to
+ * replacer_type_, sized for all frames the instance can grow to.
+ * instance.pages_ and instance.max_pool_size_ must be set
+ */
+Replacer<Page *> *
+BufferPoolManager::CreateReplacer(BufferPoolInstance &instance) {
+  switch (replacer_type_) {
+  case REPLACER_TYPE_CLOCK:
+    return new ClockReplacer<Page *>(instance.max_pool_size_, instance.pages_);
+  case REPLACER_TYPE_LRU_K:
+    return new LRUKReplacer<Page *>(instance.max_pool_size_, 2,
+                                    instance.pages_);
+  case REPLACER_TYPE_ARC:
+    return new ARCReplacer<Page *>(
+        instance.max_pool_size_,
+        [](Page *const &page) { return page->page_id_.load(); },
+        instance.pages_);
+  case REPLACER_TYPE_LRU:
+  default:
+    return new LRUReplacer<Page *>;
+  }
+}
+
+/*
+ * Private helper: take frames up to pool_size of instance into use, they go
+ * to the free list. Caller must hold instance.latch_ unless the instance is
+ * not shared yet
+ */
+void BufferPoolManager::GrowInstance(BufferPoolInstance &instance,
+                                     size_t pool_size) {
+  assert(pool_size <= instance.max_pool_size_);
+  for (size_t j = instance.pool_size_; j < pool_size; ++j) {
+    Page *page = &instance.pages_[j];
+    if (j == instance.num_constructed_) {
+      new (page) Page();
+      page->data_ = frame_arena_.GetFrame(page - pages_);
+      instance.num_constructed_++;
+    }
+    // free frames are never pinned
+    page->pin_count_ = -1;
+    instance.free_list_->push_back(page);
+  }
+  instance.pool_size_ = pool_size;
+  if (replacer_type_ == REPLACER_TYPE_ARC)
+    static_cast<ARCReplacer<Page *> *>(instance.replacer_)
+        ->SetCapacity(instance.pool_size_);
+}
+
+/*
+ * Private helper: stop using the frames of instance from pool_size on. Their
+ * pages are written back if dirty and dropped, the frames keep pin count -1
+ * so that stale lock-free lookups cannot pin them. Caller must hold
+ * instance.latch_
+ * return false, and change nothing, if one of the frames is pinned
+ */
+bool BufferPoolManager::ShrinkInstance(BufferPoolInstance &instance,
+                                       size_t pool_size) {
+  // claim all frames before touching any, the free ones already have pin
+  // count -1
+  for (size_t j = pool_size; j < instance.pool_size_; ++j) {
+    Page *page = &instance.pages_[j];
+    int unpinned = 0;
+    if (page->page_id_ == INVALID_PAGE_ID ||
+        page->pin_count_.compare_exchange_strong(unpinned, -1))
+      continue;
+    for (size_t k = pool_size; k < j; ++k) {
+      if (instance.pages_[k].page_id_ != INVALID_PAGE_ID)
+        instance.pages_[k].pin_count_ = 0;
+    }
+    return false;
+  }
+
+  Page *first_dropped = &instance.pages_[pool_size];
+  instance.free_list_->remove_if(
+      [first_dropped](Page *page) { return page >= first_dropped; });
+  for (size_t j = pool_size; j < instance.pool_size_; ++j) {
+    Page *page = &instance.pages_[j];
+    if (page->page_id_ == INVALID_PAGE_ID)
+      continue;
+    if (page->is_dirty_)
+      WriteBack(page->page_id_, page);
+    instance.page_table_->Remove(page->page_id_);
+    instance.replacer_->Erase(page);
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    // a ring that owned it notices the cleared flag
+    page->is_ring_frame_ = false;
+  }
+  frame_arena_.Release(first_dropped - pages_, instance.pool_size_ - pool_size);
+  instance.pool_size_ = pool_size;
+  if (replacer_type_ == REPLACER_TYPE_ARC)
+    static_cast<ARCReplacer<Page *> *>(instance.replacer_)
+        ->SetCapacity(instance.pool_size_);
+  return true;
+}
 } // namespace cmudb
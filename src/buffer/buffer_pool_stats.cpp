@@ -0,0 +1,131 @@
+/**
+ * buffer_pool_stats.cpp
+ */
+#include <algorithm>
+#include <sched.h>
+#include <thread>
+
+#include "buffer/buffer_pool_stats.h"
+
+namespace cmudb {
+
+const char *BufferPoolCounterName(BufferPoolCounter counter) {
+  switch (counter) {
+  case BPM_COUNTER_HITS:
+    return "hits";
+  case BPM_COUNTER_MISSES:
+    return "misses";
+  case BPM_COUNTER_EVICTIONS:
+    return "evictions";
+  case BPM_COUNTER_DIRTY_WRITEBACKS:
+    return "dirty_writebacks";
+  case BPM_COUNTER_PIN_WAITS:
+    return "pin_waits";
+  case BPM_COUNTER_FREE_LIST_EMPTY:
+    return "free_list_empty";
+  case BPM_COUNTER_REMOTE_ACCESSES:
+    return "remote_accesses";
+  default:
+    return "";
+  }
+}
+
+uint64_t GetCounterValue(const BufferPoolStatistics &stats,
+                         BufferPoolCounter counter) {
+  switch (counter) {
+  case BPM_COUNTER_HITS:
+    return stats.hits;
+  case BPM_COUNTER_MISSES:
+    return stats.misses;
+  case BPM_COUNTER_EVICTIONS:
+    return stats.evictions;
+  case BPM_COUNTER_DIRTY_WRITEBACKS:
+    return stats.dirty_writebacks;
+  case BPM_COUNTER_PIN_WAITS:
+    return stats.pin_waits;
+  case BPM_COUNTER_FREE_LIST_EMPTY:
+    return stats.free_list_empty;
+  case BPM_COUNTER_REMOTE_ACCESSES:
+    return stats.remote_accesses;
+  default:
+    return 0;
+  }
+}
+
+StripedCounters::StripedCounters()
+    : num_stripes_(std::max(1U, std::thread::hardware_concurrency())) {
+  stripes_ = new Stripe[num_stripes_];
+  Reset();
+}
+
+StripedCounters::~StripedCounters() { delete[] stripes_; }
+
+BufferPoolStatistics StripedCounters::Snapshot() const {
+  uint64_t totals[BPM_COUNTER_COUNT] = {};
+  for (size_t i = 0; i < num_stripes_; ++i) {
+    for (int j = 0; j < BPM_COUNTER_COUNT; ++j)
+      totals[j] += stripes_[i].values[j].load(std::memory_order_relaxed);
+  }
+  BufferPoolStatistics stats;
+  stats.hits = totals[BPM_COUNTER_HITS];
+  stats.misses = totals[BPM_COUNTER_MISSES];
+  stats.evictions = totals[BPM_COUNTER_EVICTIONS];
+  stats.dirty_writebacks = totals[BPM_COUNTER_DIRTY_WRITEBACKS];
+  stats.pin_waits = totals[BPM_COUNTER_PIN_WAITS];
+  stats.free_list_empty = totals[BPM_COUNTER_FREE_LIST_EMPTY];
+  stats.remote_accesses = totals[BPM_COUNTER_REMOTE_ACCESSES];
+  return stats;
+}
+
+void StripedCounters::Reset() {
+  for (size_t i = 0; i < num_stripes_; ++i) {
+    for (int j = 0; j < BPM_COUNTER_COUNT; ++j)
+      stripes_[i].values[j].store(0, std::memory_order_relaxed);
+  }
+}
+
+/*
+ * The core is looked up once per thread, a thread that migrates keeps its
+ * stripe, which costs contention but never a lost count
+ */
+size_t StripedCounters::GetStripe() const {
+  static thread_local int cpu = -1;
+  if (cpu < 0)
+    cpu = std::max(0, sched_getcpu());
+  return cpu % num_stripes_;
+}
+
+void PageHeatMap::Record(page_id_t page_id) {
+  Stripe &stripe = stripes_[static_cast<uint32_t>(page_id) % PAGE_HEAT_STRIPES];
+  std::lock_guard<std::mutex> guard(stripe.latch);
+  stripe.counts[page_id]++;
+}
+
+std::vector<std::pair<page_id_t, uint64_t>>
+PageHeatMap::Snapshot(size_t limit) {
+  std::vector<std::pair<page_id_t, uint64_t>> heat;
+  for (auto &stripe : stripes_) {
+    std::lock_guard<std::mutex> guard(stripe.latch);
+    heat.insert(heat.end(), stripe.counts.begin(), stripe.counts.end());
+  }
+  auto hotter = [](const std::pair<page_id_t, uint64_t> &a,
+                   const std::pair<page_id_t, uint64_t> &b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  };
+  if (limit != 0 && limit < heat.size()) {
+    std::partial_sort(heat.begin(), heat.begin() + limit, heat.end(), hotter);
+    heat.resize(limit);
+  } else {
+    std::sort(heat.begin(), heat.end(), hotter);
+  }
+  return heat;
+}
+
+void PageHeatMap::Reset() {
+  for (auto &stripe : stripes_) {
+    std::lock_guard<std::mutex> guard(stripe.latch);
+    stripe.counts.clear();
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,24 @@
+/**
+ * buffer_ring.cpp
+ */
+#include <algorithm>
+
+#include "buffer/buffer_ring.h"
+
+namespace cmudb {
+
+BufferRing::BufferRing(BufferPoolManager *buffer_pool_manager,
+                       size_t ring_size)
+    : buffer_pool_manager_(buffer_pool_manager),
+      slots_(buffer_pool_manager->GetNumInstances()) {
+  size_t num_instances = buffer_pool_manager_->GetNumInstances();
+  size_t instance_ring_size = std::max<size_t>(
+      2, std::min(ring_size / num_instances,
+                  buffer_pool_manager_->GetPoolSize() / num_instances / 4));
+  for (auto &slots : slots_)
+    slots.frames.resize(instance_ring_size, nullptr);
+}
+
+BufferRing::~BufferRing() { buffer_pool_manager_->ReleaseBufferRing(this); }
+
+} // namespace cmudb
@@ -0,0 +1,120 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+ClockReplacer<T>::ClockReplacer(size_t num_frames, T base)
+    : base_(base), frames_(num_frames), hand_(0), size_(0) {}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() {}
+
+/*
+ * Insert value into the clock, or give it a second chance if it is already
+ * there
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  size_t slot = FrameSlot(value);
+  assert(slot < frames_.size());
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (!frame.in_replacer) {
+    frame.value = value;
+    frame.in_replacer = true;
+    size_++;
+  }
+  frame.reference = true;
+}
+
+/*
+ * Insert value without reference bit, so it is the first to go unless it is
+ * used before the hand comes around
+ */
+template <typename T> void ClockReplacer<T>::InsertPrefetched(const T &value) {
+  size_t slot = FrameSlot(value);
+  assert(slot < frames_.size());
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (!frame.in_replacer) {
+    frame.value = value;
+    frame.in_replacer = true;
+    size_++;
+  }
+}
+
+/*
+ * Advance the clock hand until a frame without reference bit is found,
+ * clearing the bits it passes over. Two full sweeps are enough to find one.
+ * return false if the clock is empty
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (size_ == 0)
+    return false;
+  while (true) {
+    Frame &frame = frames_[hand_];
+    hand_ = (hand_ + 1) % frames_.size();
+    if (!frame.in_replacer)
+      continue;
+    if (frame.reference) {
+      frame.reference = false;
+      continue;
+    }
+    frame.in_replacer = false;
+    size_--;
+    value = frame.value;
+    return true;
+  }
+}
+
+/*
+ * The hand first takes the unreferenced frames in its way, clearing the
+ * reference bits of the others, which then go in the same order
+ */
+template <typename T> std::vector<T> ClockReplacer<T>::GetEvictionOrder() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<T> order;
+  order.reserve(size_);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < frames_.size(); ++i) {
+      const Frame &frame = frames_[(hand_ + i) % frames_.size()];
+      if (frame.in_replacer && frame.reference == (pass == 1))
+        order.push_back(frame.value);
+    }
+  }
+  return order;
+}
+
+/*
+ * Remove value from the clock. If removal is successful, return true,
+ * otherwise return false
+ */
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  size_t slot = FrameSlot(value);
+  if (slot >= frames_.size())
+    return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (!frame.in_replacer)
+    return false;
+  frame.in_replacer = false;
+  frame.reference = false;
+  size_--;
+  return true;
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace cmudb
@@ -0,0 +1,108 @@
+/**
+ * compressed_page_cache.cpp
+ */
+#include "buffer/compressed_page_cache.h"
+#include "common/lz_codec.h"
+
+namespace cmudb {
+
+CompressedPageCache::CompressedPageCache(size_t capacity)
+    : capacity_(capacity) {}
+
+void CompressedPageCache::SetCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> guard(latch_);
+  capacity_ = capacity;
+  Shrink(capacity);
+}
+
+/*
+ * The page is compressed before the latch is taken, straight into a buffer
+ * of the largest size accepted
+ */
+void CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  if (capacity_ == 0)
+    return;
+  std::string compressed(COMPRESSED_CACHE_MAX_SIZE, '\0');
+  size_t size =
+      LZCodec::Compress(data, PAGE_SIZE, &compressed[0], compressed.size());
+
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end())
+    Remove(it);
+  if (size == 0 || size > capacity_) {
+    stats_.rejects++;
+    return;
+  }
+  compressed.resize(size);
+  compressed.shrink_to_fit();
+  Shrink(capacity_ - size);
+  lru_.push_front(page_id);
+  entries_[page_id] = Entry{std::move(compressed), lru_.begin()};
+  size_ += size;
+  stats_.inserts++;
+}
+
+bool CompressedPageCache::Take(page_id_t page_id, char *data) {
+  if (capacity_ == 0)
+    return false;
+  std::string compressed;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = entries_.find(page_id);
+    if (it == entries_.end()) {
+      stats_.misses++;
+      return false;
+    }
+    stats_.hits++;
+    compressed = std::move(it->second.data);
+    size_ -= compressed.size();
+    lru_.erase(it->second.position);
+    entries_.erase(it);
+  }
+  return LZCodec::Decompress(compressed.data(), compressed.size(), data,
+                             PAGE_SIZE);
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end())
+    Remove(it);
+}
+
+CompressedCacheStatistics CompressedPageCache::GetStatistics() {
+  std::lock_guard<std::mutex> guard(latch_);
+  CompressedCacheStatistics stats = stats_;
+  stats.num_pages = entries_.size();
+  stats.size = size_;
+  return stats;
+}
+
+void CompressedPageCache::ResetStatistics() {
+  std::lock_guard<std::mutex> guard(latch_);
+  stats_ = CompressedCacheStatistics();
+}
+
+/*
+ * Private helper: drop the least recently inserted pages until at most
+ * capacity bytes are left. Caller must hold latch_
+ */
+void CompressedPageCache::Shrink(size_t capacity) {
+  while (size_ > capacity) {
+    Remove(entries_.find(lru_.back()));
+    stats_.evictions++;
+  }
+}
+
+/*
+ * Private helper: drop the entry at it. Caller must hold latch_
+ */
+void CompressedPageCache::Remove(
+    std::unordered_map<page_id_t, Entry>::iterator it) {
+  size_ -= it->second.data.size();
+  lru_.erase(it->second.position);
+  entries_.erase(it);
+}
+
+} // namespace cmudb
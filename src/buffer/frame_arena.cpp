@@ -0,0 +1,102 @@
+/**
+ * frame_arena.cpp
+ */
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "buffer/frame_arena.h"
+
+// not exported by older C libraries
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+namespace cmudb {
+
+static const size_t HUGE_PAGE_2MB = 2UL << 20;
+static const size_t HUGE_PAGE_1GB = 1UL << 30;
+
+FrameArena::FrameArena(size_t num_frames, bool use_huge_pages)
+    : base_(nullptr), num_frames_(num_frames), mapped_size_(0),
+      page_size_(sysconf(_SC_PAGESIZE)), page_type_(ARENA_PAGE_REGULAR) {
+  if (!use_huge_pages) {
+    MapAligned(page_size_);
+    return;
+  }
+  if (num_frames_ * PAGE_SIZE >= HUGE_PAGE_1GB &&
+      MapHugeTLB(HUGE_PAGE_1GB, 30 << MAP_HUGE_SHIFT)) {
+    page_type_ = ARENA_PAGE_HUGETLB_1GB;
+  } else if (MapHugeTLB(HUGE_PAGE_2MB, 21 << MAP_HUGE_SHIFT)) {
+    page_type_ = ARENA_PAGE_HUGETLB_2MB;
+  } else {
+    // transparent huge pages need 2MB aligned memory, the mapping is still
+    // fine with regular pages if the kernel does not support them
+    MapAligned(HUGE_PAGE_2MB);
+#ifdef MADV_HUGEPAGE
+    if (madvise(base_, mapped_size_, MADV_HUGEPAGE) == 0)
+      page_type_ = ARENA_PAGE_TRANSPARENT_HUGE;
+#endif
+  }
+}
+
+FrameArena::~FrameArena() { munmap(base_, mapped_size_); }
+
+void FrameArena::Release(size_t first_frame_id, size_t num_frames) {
+  // round inwards, a partially covered page may still be in use
+  size_t begin = first_frame_id * PAGE_SIZE;
+  size_t end = (first_frame_id + num_frames) * PAGE_SIZE;
+  begin = (begin + page_size_ - 1) / page_size_ * page_size_;
+  end = end / page_size_ * page_size_;
+  if (begin < end)
+    madvise(base_ + begin, end - begin, MADV_DONTNEED);
+}
+
+/*
+ * Private helper: map the arena from hugetlbfs pages of huge_page_size,
+ * fails if the kernel has not enough of them reserved
+ */
+bool FrameArena::MapHugeTLB(size_t huge_page_size, int size_flag) {
+#ifdef MAP_HUGETLB
+  size_t size = (num_frames_ * PAGE_SIZE + huge_page_size - 1) /
+                huge_page_size * huge_page_size;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | size_flag,
+                      -1, 0);
+  if (memory == MAP_FAILED)
+    return false;
+  base_ = static_cast<char *>(memory);
+  mapped_size_ = size;
+  page_size_ = huge_page_size;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Private helper: map the arena from regular pages, starting at a multiple
+ * of alignment
+ */
+void FrameArena::MapAligned(size_t alignment) {
+  size_t size =
+      (num_frames_ * PAGE_SIZE + alignment - 1) / alignment * alignment;
+  // over-allocate and trim to an aligned range
+  size_t slack = alignment > page_size_ ? alignment : 0;
+  void *memory = mmap(nullptr, size + slack, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+    throw std::bad_alloc();
+  char *start = static_cast<char *>(memory);
+  char *aligned = reinterpret_cast<char *>(
+      (reinterpret_cast<uintptr_t>(start) + alignment - 1) & ~(alignment - 1));
+  if (aligned > start)
+    munmap(start, aligned - start);
+  if (start + size + slack > aligned + size)
+    munmap(aligned + size, start + size + slack - (aligned + size));
+  base_ = aligned;
+  mapped_size_ = size;
+}
+
+} // namespace cmudb
@@ -0,0 +1,126 @@
+/**
+ * LRU-K implementation
+ */
+#include <cassert>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t num_frames, size_t k, T base)
+    : k_(k), base_(base), frames_(num_frames), current_timestamp_(0) {
+  assert(k_ > 0);
+}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record an access of value and make it evictable
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  size_t slot = FrameSlot(value);
+  assert(slot < frames_.size());
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (frame.in_replacer)
+    evictable_.erase(GetEvictionKey(slot));
+  // the read ahead was not an access, this is the first one
+  if (frame.prefetched)
+    frame.history.clear();
+  frame.value = value;
+  frame.in_replacer = true;
+  frame.prefetched = false;
+  frame.history.push_back(current_timestamp_++);
+  if (frame.history.size() > k_)
+    frame.history.pop_front();
+  evictable_.insert(GetEvictionKey(slot));
+}
+
+/*
+ * Make value evictable with a single timestamp that the next Insert replaces,
+ * so a page read ahead and then used once still has a single access
+ */
+template <typename T>
+void LRUKReplacer<T>::InsertPrefetched(const T &value) {
+  size_t slot = FrameSlot(value);
+  assert(slot < frames_.size());
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (frame.in_replacer)
+    evictable_.erase(GetEvictionKey(slot));
+  frame.value = value;
+  frame.in_replacer = true;
+  frame.prefetched = true;
+  frame.history.clear();
+  frame.history.push_back(current_timestamp_++);
+  evictable_.insert(GetEvictionKey(slot));
+}
+
+/*
+ * Pop the evictable frame with the largest backward K-distance to argument
+ * "value" and forget its history. If no frame is evictable, return false
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (evictable_.empty())
+    return false;
+  size_t slot = std::get<2>(*evictable_.begin());
+  evictable_.erase(evictable_.begin());
+  Frame &frame = frames_[slot];
+  frame.in_replacer = false;
+  frame.prefetched = false;
+  frame.history.clear();
+  value = frame.value;
+  return true;
+}
+
+template <typename T> std::vector<T> LRUKReplacer<T>::GetEvictionOrder() {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<T> order;
+  order.reserve(evictable_.size());
+  for (const EvictionKey &key : evictable_)
+    order.push_back(frames_[std::get<2>(key)].value);
+  return order;
+}
+
+/*
+ * Make value non-evictable, its access history is kept. If removal is
+ * successful, return true, otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  size_t slot = FrameSlot(value);
+  if (slot >= frames_.size())
+    return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  Frame &frame = frames_[slot];
+  if (!frame.in_replacer)
+    return false;
+  evictable_.erase(GetEvictionKey(slot));
+  frame.in_replacer = false;
+  return true;
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_.size();
+}
+
+/*
+ * Private helper: frames with fewer than K accesses sort first by their
+ * oldest access, the others by their K-th most recent access. Either way the
+ * front of the deque is the deciding timestamp. Caller must hold latch_
+ */
+template <typename T>
+typename LRUKReplacer<T>::EvictionKey
+LRUKReplacer<T>::GetEvictionKey(size_t slot) const {
+  const Frame &frame = frames_[slot];
+  return EvictionKey(frame.history.size() >= k_, frame.history.front(), slot);
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace cmudb
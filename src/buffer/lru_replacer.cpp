@@ -6,20 +6,38 @@
 
 namespace cmudb {
 
-template <typename T> LRUReplacer<T>::LRUReplacer() {}
+template <typename T> LRUReplacer<T>::LRUReplacer() : index_(BUCKET_SIZE) {}
 
 template <typename T> LRUReplacer<T>::~LRUReplacer() {}
 
 /*
  * Insert value into LRU
  */
-template <typename T> void LRUReplacer<T>::Insert(const T &value) {}
+template <typename T> void LRUReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  typename std::list<T>::iterator it;
+  if (index_.Find(value, it))
+    lru_list_.erase(it);
+  lru_list_.push_front(value);
+  index_.Insert(value, lru_list_.begin());
+}
 
 /* If LRU is non-empty, pop the head member from LRU to argument "value", and
  * return true. If LRU is empty, return false
  */
 template <typename T> bool LRUReplacer<T>::Victim(T &value) {
-  return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  if (lru_list_.empty())
+    return false;
+  value = lru_list_.back();
+  lru_list_.pop_back();
+  index_.Remove(value);
+  return true;
+}
+
+template <typename T> std::vector<T> LRUReplacer<T>::GetEvictionOrder() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return std::vector<T>(lru_list_.rbegin(), lru_list_.rend());
 }
 
 /*
@@ -27,10 +45,19 @@ template <typename T> bool LRUReplacer<T>::Victim(T &value) {
  * return false
  */
 template <typename T> bool LRUReplacer<T>::Erase(const T &value) {
-  return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  typename std::list<T>::iterator it;
+  if (!index_.Find(value, it))
+    return false;
+  lru_list_.erase(it);
+  index_.Remove(value);
+  return true;
 }
 
-template <typename T> size_t LRUReplacer<T>::Size() { return 0; }
+template <typename T> size_t LRUReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return lru_list_.size();
+}
 
 template class LRUReplacer<Page *>;
 // test only
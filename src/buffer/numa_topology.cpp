@@ -0,0 +1,106 @@
+/**
+ * numa_topology.cpp
+ */
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/numa_topology.h"
+
+namespace cmudb {
+
+static thread_local int thread_node = -1;
+
+/*
+ * Parse a sysfs list like "0-3,8,10-11" into its numbers
+ */
+static std::vector<size_t> ParseRangeList(const std::string &list) {
+  std::vector<size_t> values;
+  size_t pos = 0;
+  while (pos < list.size() && isdigit(list[pos])) {
+    size_t end;
+    size_t first = std::stoul(list.substr(pos), &end);
+    pos += end;
+    size_t last = first;
+    if (pos < list.size() && list[pos] == '-') {
+      last = std::stoul(list.substr(pos + 1), &end);
+      pos += end + 1;
+    }
+    for (size_t value = first; value <= last; ++value)
+      values.push_back(value);
+    if (pos < list.size() && list[pos] == ',')
+      pos++;
+  }
+  return values;
+}
+
+NumaTopology::NumaTopology(NumaMode mode) : mode_(mode), num_nodes_(1) {
+  if (mode_ == NUMA_MODE_EMULATE)
+    num_nodes_ = NUMA_EMULATED_NODES;
+  else if (mode_ == NUMA_MODE_BIND)
+    ReadSystemNodes();
+}
+
+size_t NumaTopology::GetCurrentNode() const {
+  if (thread_node >= 0)
+    return thread_node % num_nodes_;
+  int cpu = sched_getcpu();
+  if (cpu < 0)
+    return 0;
+  if (static_cast<size_t>(cpu) < cpu_node_.size())
+    return cpu_node_[cpu];
+  return cpu % num_nodes_;
+}
+
+bool NumaTopology::BindMemory(void *address, size_t size, size_t node,
+                              size_t page_size) const {
+  if (mode_ != NUMA_MODE_BIND)
+    return false;
+  if (page_size == 0)
+    page_size = sysconf(_SC_PAGESIZE);
+  // round inwards, the pages at the edges may belong to a neighbour
+  uintptr_t begin = reinterpret_cast<uintptr_t>(address);
+  uintptr_t end = (begin + size) / page_size * page_size;
+  begin = (begin + page_size - 1) / page_size * page_size;
+  if (begin >= end)
+    return false;
+  const size_t bits = sizeof(unsigned long) * CHAR_BIT;
+  std::vector<unsigned long> node_mask(node / bits + 1);
+  node_mask[node / bits] |= 1UL << (node % bits);
+  return syscall(SYS_mbind, begin, end - begin, MPOL_BIND, node_mask.data(),
+                 node_mask.size() * bits + 1, MPOL_MF_MOVE) == 0;
+}
+
+void NumaTopology::SetThreadNode(int node) { thread_node = node; }
+
+/*
+ * Private helper: map the cpus of the machine onto its nodes, a single node
+ * if sysfs does not list them
+ */
+void NumaTopology::ReadSystemNodes() {
+  const std::string node_dir = "/sys/devices/system/node/";
+  std::ifstream online(node_dir + "online");
+  std::string list;
+  if (!std::getline(online, list))
+    return;
+  for (size_t node : ParseRangeList(list)) {
+    std::ifstream cpus(node_dir + "node" + std::to_string(node) + "/cpulist");
+    std::string cpu_list;
+    std::getline(cpus, cpu_list);
+    for (size_t cpu : ParseRangeList(cpu_list)) {
+      if (cpu >= cpu_node_.size())
+        cpu_node_.resize(cpu + 1, 0);
+      cpu_node_[cpu] = node;
+    }
+    num_nodes_ = std::max(num_nodes_, node + 1);
+  }
+}
+
+} // namespace cmudb
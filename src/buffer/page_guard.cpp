@@ -0,0 +1,26 @@
+/**
+ * page_guard.cpp
+ */
+
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+void ReadPageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->RUnlock();
+  buffer_pool_manager_->ReleasePage(page_, false);
+  page_ = nullptr;
+}
+
+void WritePageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->WUnlock();
+  buffer_pool_manager_->ReleasePage(page_, is_dirty_);
+  page_ = nullptr;
+}
+
+} // namespace cmudb
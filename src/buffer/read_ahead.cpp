@@ -0,0 +1,43 @@
+/**
+ * read_ahead.cpp
+ */
+#include <algorithm>
+
+#include "buffer/read_ahead.h"
+
+namespace cmudb {
+
+ReadAhead::ReadAhead(BufferPoolManager *buffer_pool_manager, size_t window)
+    : buffer_pool_manager_(buffer_pool_manager),
+      window_(buffer_pool_manager->GetIOMode() == DISK_IO_MMAP
+                  ? window
+                  : std::min(window, buffer_pool_manager->GetPoolSize() / 4)),
+      last_page_id_(INVALID_PAGE_ID), prefetched_until_(INVALID_PAGE_ID) {}
+
+/*
+ * Record that the scan moved to page_id and issue read-ahead if the scan is
+ * sequential
+ */
+void ReadAhead::OnPageAccess(page_id_t page_id) {
+  bool is_sequential =
+      last_page_id_ != INVALID_PAGE_ID && page_id == last_page_id_ + 1;
+  last_page_id_ = page_id;
+  if (window_ == 0 || page_id == INVALID_PAGE_ID)
+    return;
+  if (!is_sequential) {
+    // anything requested for an earlier run is of no use any more
+    prefetched_until_ = page_id + 1;
+    return;
+  }
+  if (page_id + static_cast<page_id_t>(window_ / 2) < prefetched_until_)
+    return;
+  page_id_t first_page_id = std::max(page_id + 1, prefetched_until_);
+  prefetched_until_ = page_id + 1 + static_cast<page_id_t>(window_);
+  buffer_pool_manager_->AdvisePages(first_page_id,
+                                    prefetched_until_ - first_page_id,
+                                    DISK_ADVICE_SEQUENTIAL);
+  buffer_pool_manager_->PrefetchPages(first_page_id,
+                                      prefetched_until_ - first_page_id);
+}
+
+} // namespace cmudb
@@ -0,0 +1,166 @@
+/**
+ * crc32c.cpp
+ */
+#include "common/crc32c.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace cmudb {
+
+// bit reflected 0x1EDC6F41
+static const uint32_t POLYNOMIAL = 0x82F63B78;
+// bytes of each of the three streams of the hardware implementation, three
+// of them cover a page with a checksum trailer but for a few bytes
+static const size_t STREAM_SIZE = 1360;
+
+/*
+ * Lookup tables, built on first use. Everything here works on the raw CRC
+ * register, the inversion before and after is left to the callers
+ */
+struct CRC32CTables {
+  CRC32CTables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc >> 1) ^ (crc & 1 ? POLYNOMIAL : 0);
+      slices[0][i] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+      for (int i = 0; i < 256; ++i) {
+        uint32_t crc = slices[k - 1][i];
+        slices[k][i] = (crc >> 8) ^ slices[0][crc & 0xff];
+      }
+    }
+    // the register is linear in its bits, so shifting is the xor of the
+    // shifted bits
+    uint32_t shifted_bits[32];
+    for (int bit = 0; bit < 32; ++bit) {
+      uint32_t crc = uint32_t(1) << bit;
+      for (size_t i = 0; i < STREAM_SIZE; ++i)
+        crc = (crc >> 8) ^ slices[0][crc & 0xff];
+      shifted_bits[bit] = crc;
+    }
+    for (int k = 0; k < 4; ++k) {
+      for (int i = 0; i < 256; ++i) {
+        uint32_t crc = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+          if (i & (1 << bit))
+            crc ^= shifted_bits[k * 8 + bit];
+        }
+        shift[k][i] = crc;
+      }
+    }
+  }
+
+  // slices[k][b]: the register after byte b followed by k zero bytes
+  uint32_t slices[8][256];
+  // shift[k][b]: the register b << (8 * k) after STREAM_SIZE zero bytes
+  uint32_t shift[4][256];
+};
+
+static const CRC32CTables &GetTables() {
+  static const CRC32CTables tables;
+  return tables;
+}
+
+static inline uint32_t Load32(const unsigned char *p) {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 |
+         uint32_t(p[3]) << 24;
+}
+
+/*
+ * Slicing-by-8 over the raw register
+ */
+static uint32_t UpdatePortable(uint32_t crc, const unsigned char *p,
+                               size_t size) {
+  const CRC32CTables &tables = GetTables();
+  const uint32_t(*t)[256] = tables.slices;
+  for (; size >= 8; size -= 8, p += 8) {
+    uint32_t low = crc ^ Load32(p);
+    uint32_t high = Load32(p + 4);
+    crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+          t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^ t[3][high & 0xff] ^
+          t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^
+          t[0][high >> 24];
+  }
+  for (; size > 0; --size, ++p)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+  return crc;
+}
+
+#if defined(__x86_64__)
+/*
+ * The register after STREAM_SIZE zero bytes
+ */
+static inline uint32_t ShiftStream(const CRC32CTables &tables, uint32_t crc) {
+  return tables.shift[0][crc & 0xff] ^ tables.shift[1][(crc >> 8) & 0xff] ^
+         tables.shift[2][(crc >> 16) & 0xff] ^ tables.shift[3][crc >> 24];
+}
+
+/*
+ * crc32 instruction over the raw register. The instruction takes 3 cycles
+ * but can start one per cycle, so blocks of three streams are checksummed
+ * side by side and combined: the checksum of a || b is that of a shifted
+ * over the length of b, xor that of b alone
+ */
+__attribute__((target("sse4.2"))) static uint32_t
+UpdateHardware(uint32_t crc, const unsigned char *p, size_t size) {
+  const CRC32CTables &tables = GetTables();
+  uint64_t crc0 = crc;
+  for (; size >= 3 * STREAM_SIZE;
+       size -= 3 * STREAM_SIZE, p += 3 * STREAM_SIZE) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (size_t i = 0; i < STREAM_SIZE; i += 8) {
+      uint64_t word0, word1, word2;
+      __builtin_memcpy(&word0, p + i, 8);
+      __builtin_memcpy(&word1, p + STREAM_SIZE + i, 8);
+      __builtin_memcpy(&word2, p + 2 * STREAM_SIZE + i, 8);
+      crc0 = _mm_crc32_u64(crc0, word0);
+      crc1 = _mm_crc32_u64(crc1, word1);
+      crc2 = _mm_crc32_u64(crc2, word2);
+    }
+    crc0 = ShiftStream(tables, ShiftStream(tables, crc0) ^ crc1) ^ crc2;
+  }
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t word;
+    __builtin_memcpy(&word, p, 8);
+    crc0 = _mm_crc32_u64(crc0, word);
+  }
+  uint32_t crc32 = static_cast<uint32_t>(crc0);
+  for (; size > 0; --size, ++p)
+    crc32 = _mm_crc32_u8(crc32, *p);
+  return crc32;
+}
+#endif
+
+bool CRC32C::IsHardwareAccelerated() {
+#if defined(__x86_64__)
+  static const bool has_hardware = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+  }();
+  return has_hardware;
+#else
+  return false;
+#endif
+}
+
+uint32_t CRC32C::Checksum(const char *data, size_t size, uint32_t crc) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+#if defined(__x86_64__)
+  if (IsHardwareAccelerated())
+    return ~UpdateHardware(~crc, p, size);
+#endif
+  return ~UpdatePortable(~crc, p, size);
+}
+
+uint32_t CRC32C::ChecksumPortable(const char *data, size_t size,
+                                  uint32_t crc) {
+  return ~UpdatePortable(~crc, reinterpret_cast<const unsigned char *>(data),
+                         size);
+}
+
+} // namespace cmudb
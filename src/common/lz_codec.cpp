@@ -0,0 +1,174 @@
+/**
+ * lz_codec.cpp
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/lz_codec.h"
+
+namespace cmudb {
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+// the last literals are never part of a match, as in LZ4
+static const size_t LAST_LITERALS = 5;
+static const size_t MATCH_LIMIT = 12;
+static const int HASH_BITS = 12;
+
+static inline uint32_t Read32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/*
+ * Append the extra bytes of a length that did not fit into its 4 bits
+ * return false if they do not fit into [op, end)
+ */
+static bool WriteLength(char *&op, const char *end, size_t length) {
+  for (; length >= 255; length -= 255) {
+    if (op == end)
+      return false;
+    *op++ = static_cast<char>(255);
+  }
+  if (op == end)
+    return false;
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+/*
+ * Add the extra bytes of a length at ip to length
+ * return false if they run past end
+ */
+static bool ReadLength(const unsigned char *&ip, const unsigned char *end,
+                       size_t &length) {
+  unsigned char byte;
+  do {
+    if (ip == end)
+      return false;
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/*
+ * Append a sequence: literals [literals, literals + num_literals), then a
+ * match of match_length bytes at offset back, none if match_length is 0
+ */
+static bool WriteSequence(char *&op, const char *end, const char *literals,
+                          size_t num_literals, size_t offset,
+                          size_t match_length) {
+  if (op == end)
+    return false;
+  char *token = op++;
+  size_t literal_code = num_literals < 15 ? num_literals : 15;
+  size_t match_code = 0;
+  if (match_length != 0)
+    match_code = match_length - MIN_MATCH < 15 ? match_length - MIN_MATCH : 15;
+  *token = static_cast<char>(literal_code << 4 | match_code);
+  if (literal_code == 15 && !WriteLength(op, end, num_literals - 15))
+    return false;
+  if (static_cast<size_t>(end - op) < num_literals)
+    return false;
+  if (num_literals != 0)
+    memcpy(op, literals, num_literals);
+  op += num_literals;
+  if (match_length == 0)
+    return true;
+  if (end - op < 2)
+    return false;
+  *op++ = static_cast<char>(offset & 0xff);
+  *op++ = static_cast<char>(offset >> 8);
+  if (match_code == 15 && !WriteLength(op, end, match_length - MIN_MATCH - 15))
+    return false;
+  return true;
+}
+
+size_t LZCodec::Compress(const char *src, size_t size, char *dst,
+                         size_t capacity) {
+  char *op = dst;
+  const char *end = dst + capacity;
+  size_t anchor = 0;
+  if (size >= MATCH_LIMIT) {
+    // positions + 1 of the last prefix with every hash, 0 for none
+    std::vector<uint32_t> table(1 << HASH_BITS, 0);
+    size_t ip = 0;
+    while (ip + MATCH_LIMIT <= size) {
+      uint32_t sequence = Read32(src + ip);
+      uint32_t &entry = table[Hash(sequence)];
+      size_t ref = entry;
+      entry = static_cast<uint32_t>(ip + 1);
+      if (ref == 0 || ip - (ref - 1) > MAX_OFFSET ||
+          Read32(src + ref - 1) != sequence) {
+        ip++;
+        continue;
+      }
+      ref--;
+      size_t length = MIN_MATCH;
+      while (ip + length < size - LAST_LITERALS &&
+             src[ref + length] == src[ip + length])
+        length++;
+      if (!WriteSequence(op, end, src + anchor, ip - anchor, ip - ref, length))
+        return 0;
+      ip += length;
+      anchor = ip;
+    }
+  }
+  if (!WriteSequence(op, end, src + anchor, size - anchor, 0, 0))
+    return 0;
+  return op - dst;
+}
+
+bool LZCodec::Decompress(const char *src, size_t size, char *dst,
+                         size_t dst_size) {
+  const unsigned char *ip = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *end = ip + size;
+  size_t op = 0;
+  while (ip < end) {
+    unsigned char token = *ip++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !ReadLength(ip, end, num_literals))
+      return false;
+    if (static_cast<size_t>(end - ip) < num_literals ||
+        dst_size - op < num_literals)
+      return false;
+    if (num_literals != 0)
+      memcpy(dst + op, ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    // the last sequence ends after its literals
+    if (ip == end)
+      break;
+
+    if (end - ip < 2)
+      return false;
+    size_t offset = ip[0] | ip[1] << 8;
+    ip += 2;
+    size_t length = token & 15;
+    if (length == 15 && !ReadLength(ip, end, length))
+      return false;
+    length += MIN_MATCH;
+    if (offset == 0 || offset > op || dst_size - op < length)
+      return false;
+    // the match may overlap what it produces, so it is copied in chunks
+    // that do not: the bytes copied so far repeat every offset bytes, each
+    // chunk doubles the source
+    for (size_t copied = 0; copied < length;) {
+      size_t chunk = std::min(length - copied, offset + copied);
+      memcpy(dst + op + copied, dst + op - offset, chunk);
+      copied += chunk;
+    }
+    op += length;
+  }
+  return op == dst_size;
+}
+
+} // namespace cmudb
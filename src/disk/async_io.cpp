@@ -0,0 +1,252 @@
+/**
+ * async_io.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "disk/async_io.h"
+
+namespace cmudb {
+
+AsyncIOEngine *AsyncIOEngine::Create(AsyncIOBackend backend) {
+  if (backend != ASYNC_IO_THREAD_POOL) {
+    IOUringEngine *engine = new IOUringEngine();
+    if (engine->Init(ASYNC_IO_QUEUE_DEPTH))
+      return engine;
+    delete engine;
+  }
+  return new ThreadPoolEngine(ASYNC_IO_THREADS);
+}
+
+/*===----------------------------------------------------------------------===
+ * io_uring
+ *===----------------------------------------------------------------------===*/
+
+IOUringEngine::IOUringEngine()
+    : ring_fd_(-1), num_entries_(0), sq_ring_(nullptr), sq_ring_size_(0),
+      cq_ring_(nullptr), cq_ring_size_(0), sqes_(nullptr), sqes_size_(0) {}
+
+IOUringEngine::~IOUringEngine() {
+  if (completion_thread_.joinable()) {
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      stopping_ = true;
+      slot_cv_.wait(lock, [this] { return num_in_flight_ == 0; });
+      // wakes the completion thread, which finds nothing left in flight
+      PushEntry(nullptr);
+    }
+    completion_thread_.join();
+  }
+  if (sqes_ != nullptr)
+    munmap(sqes_, sqes_size_);
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != nullptr)
+    munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0)
+    close(ring_fd_);
+}
+
+bool IOUringEngine::Init(unsigned num_entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, num_entries, &params);
+  if (ring_fd_ < 0)
+    return false;
+  num_entries_ = params.sq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  // newer kernels map both rings with one call
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED)
+    return false;
+  sq_ring_ = static_cast<char *>(sq_ring);
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void *cq_ring =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED)
+      return false;
+    cq_ring_ = static_cast<char *>(cq_ring);
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    return false;
+  sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+  sq_tail_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.ring_mask);
+  cqes_ =
+      reinterpret_cast<struct io_uring_cqe *>(cq_ring_ + params.cq_off.cqes);
+  completion_thread_ = std::thread(&IOUringEngine::CompletionLoop, this);
+  return true;
+}
+
+void IOUringEngine::Submit(AsyncIORequest *request) {
+  std::unique_lock<std::mutex> lock(latch_);
+  slot_cv_.wait(lock, [this] { return num_in_flight_ < num_entries_; });
+  num_in_flight_++;
+  PushEntry(request);
+}
+
+/*
+ * Private helper: queue a submission entry for request, a no-op for nullptr,
+ * and hand it to the kernel. Caller must hold latch_
+ */
+void IOUringEngine::PushEntry(AsyncIORequest *request) {
+  // the kernel consumes the entries in io_uring_enter, so the ring is empty
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  struct io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+  } else {
+    sqe->opcode =
+        request->op == ASYNC_IO_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = request->fd;
+    sqe->off = request->offset;
+    sqe->addr = reinterpret_cast<uint64_t>(request->iov.data());
+    sqe->len = request->iov.size();
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0 &&
+         (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+  }
+}
+
+/*
+ * Private helper: body of the completion thread, runs the callbacks
+ */
+void IOUringEngine::CompletionLoop() {
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      {
+        std::lock_guard<std::mutex> guard(latch_);
+        if (stopping_ && num_in_flight_ == 0)
+          break;
+      }
+      syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+              nullptr, 0);
+      continue;
+    }
+    struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+    AsyncIORequest *request =
+        reinterpret_cast<AsyncIORequest *>(cqe->user_data);
+    ssize_t result = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    if (request == nullptr)
+      continue;
+    request->callback(result);
+    delete request;
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      num_in_flight_--;
+    }
+    slot_cv_.notify_all();
+  }
+}
+
+/*===----------------------------------------------------------------------===
+ * thread pool
+ *===----------------------------------------------------------------------===*/
+
+/*
+ * Transfer all of request with blocking calls, reads stop at the end of the
+ * file
+ * return the bytes transferred, or -errno
+ */
+static ssize_t Transfer(AsyncIORequest *request) {
+  std::vector<struct iovec> &iov = request->iov;
+  size_t first = 0;
+  ssize_t total = 0;
+  while (first < iov.size()) {
+    ssize_t done =
+        request->op == ASYNC_IO_READ
+            ? preadv(request->fd, &iov[first], iov.size() - first,
+                     request->offset + total)
+            : pwritev(request->fd, &iov[first], iov.size() - first,
+                      request->offset + total);
+    if (done < 0 && errno == EINTR)
+      continue;
+    if (done < 0)
+      return -errno;
+    if (done == 0)
+      break;
+    total += done;
+    // skip what was transferred
+    while (first < iov.size() &&
+           static_cast<size_t>(done) >= iov[first].iov_len)
+      done -= iov[first++].iov_len;
+    if (first < iov.size()) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + done;
+      iov[first].iov_len -= done;
+    }
+  }
+  return total;
+}
+
+ThreadPoolEngine::ThreadPoolEngine(size_t num_threads) {
+  for (size_t i = 0; i < num_threads; ++i)
+    workers_.emplace_back(&ThreadPoolEngine::WorkerLoop, this);
+}
+
+ThreadPoolEngine::~ThreadPoolEngine() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    stopping_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &worker : workers_)
+    worker.join();
+}
+
+void ThreadPoolEngine::Submit(AsyncIORequest *request) {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    queue_.push_back(request);
+  }
+  queue_cv_.notify_one();
+}
+
+/*
+ * Private helper: body of a worker thread
+ */
+void ThreadPoolEngine::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    queue_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty())
+      break;
+    AsyncIORequest *request = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    request->callback(Transfer(request));
+    delete request;
+    lock.lock();
+  }
+}
+
+} // namespace cmudb
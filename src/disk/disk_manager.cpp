@@ -1,96 +1,1180 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstring>
-#include <iostream>
+#include <fcntl.h>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
 
+#include "common/crc32c.h"
+#include "common/exception.h"
 #include "common/logger.h"
+#include "common/lz_codec.h"
 #include "disk/disk_manager.h"
 
 namespace cmudb {
 
+// pages are read and written in units of the disk's sectors
+static_assert(PAGE_SIZE > 0 && PAGE_SIZE % 512 == 0 &&
+                  (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "PAGE_SIZE must be a power of two multiple of 512");
+static_assert(COMPRESSED_SLOT_SIZE % 512 == 0 &&
+                  PAGE_SIZE % COMPRESSED_SLOT_SIZE == 0,
+              "COMPRESSED_SLOT_SIZE must be a multiple of 512 dividing "
+              "PAGE_SIZE");
+
+// slots of a page stored as is
+static const uint32_t MAX_PAGE_SLOTS = PAGE_SIZE / COMPRESSED_SLOT_SIZE;
+// the size in front of the compressed bytes
+static const size_t COMPRESSED_HEADER_SIZE = 2;
+
+/*
+ * size bytes aligned for O_DIRECT, release with free()
+ */
+static char *AllocateAligned(size_t size) {
+  void *buffer = nullptr;
+  if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, size) != 0)
+    throw std::bad_alloc();
+  return static_cast<char *>(buffer);
+}
+
+/*
+ * Write size bytes of data to fd at offset, return false on an I/O error
+ */
+static bool WriteAll(int fd, const char *data, size_t size, off_t offset) {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(fd, data + written, size - written, offset + written);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    if (rc <= 0)
+      return false;
+    written += rc;
+  }
+  return true;
+}
+
+/*
+ * Read up to size bytes of fd at offset into data, return the bytes read,
+ * fewer at the end of the file or on an I/O error
+ */
+static size_t ReadAll(int fd, char *data, size_t size, off_t offset) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(fd, data + read_count, size - read_count,
+                       offset + read_count);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    // end of file or I/O error
+    if (rc <= 0)
+      break;
+    read_count += rc;
+  }
+  return read_count;
+}
+
+/*
+ * Give the blocks of num_slots slots from first_slot back to the file
+ * system, they read as zeros. An optimization only, like the preallocation
+ */
+static void PunchSlots(int fd, uint32_t first_slot, uint32_t num_slots) {
+  if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                static_cast<off_t>(first_slot) * COMPRESSED_SLOT_SIZE,
+                static_cast<off_t>(num_slots) * COMPRESSED_SLOT_SIZE) != 0) {
+    LOG_DEBUG("cannot punch a hole: %s", strerror(errno));
+  }
+}
+
 /**
  * Constructor: open/create a single database file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0) {
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+DiskManager::DiskManager(const std::string &db_file, AsyncIOBackend backend,
+                         DiskIOMode io_mode, DiskCompression compression)
+    : file_name_(db_file), io_mode_(io_mode), compression_(compression),
+      next_page_id_(0), async_io_backend_(backend) {
+  if (io_mode_ == DISK_IO_MMAP && compression_ != DISK_COMPRESSION_NONE)
+    throw Exception("compressed database file " + db_file +
+                    " cannot be mapped");
+  struct stat stat_buf;
+  bool is_new_file = stat(db_file.c_str(), &stat_buf) != 0;
+  int flags = O_RDWR | O_CREAT;
+  if (io_mode_ == DISK_IO_DIRECT) {
+    db_fd_ = open(db_file.c_str(), flags | O_DIRECT, 0644);
+    // e.g. tmpfs
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_WARN("O_DIRECT not supported for %s", db_file.c_str());
+      io_mode_ = DISK_IO_BUFFERED;
+    }
+  }
+  if (io_mode_ == DISK_IO_BUFFERED)
+    db_fd_ = open(db_file.c_str(), flags, 0644);
+  if (io_mode_ == DISK_IO_MMAP)
+    db_fd_ = open(db_file.c_str(), O_RDONLY);
+  if (db_fd_ < 0)
+    throw Exception("cannot open database file " + db_file + ": " +
+                    strerror(errno));
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    close(db_fd_);
+    throw Exception("cannot stat database file " + db_file);
+  }
+  file_size_ = stat_buf.st_size;
+  fsm_file_name_ = db_file + ".fsm";
+  location_file_name_ = db_file + ".loc";
+  try {
+    LoadLocationMap(is_new_file);
+  } catch (Exception &) {
+    close(db_fd_);
+    throw;
+  }
+  // most likely written with another PAGE_SIZE
+  size_t unit = compression_ == DISK_COMPRESSION_NONE ? PAGE_SIZE
+                                                      : COMPRESSED_SLOT_SIZE;
+  if (stat_buf.st_size % unit != 0) {
+    close(db_fd_);
+    if (location_fd_ >= 0)
+      close(location_fd_);
+    throw Exception("size of database file " + db_file +
+                    " is not a multiple of the " +
+                    (unit == PAGE_SIZE ? "page" : "slot") + " size " +
+                    std::to_string(unit));
   }
+  if (io_mode_ == DISK_IO_MMAP) {
+    // mmap refuses an empty mapping, there is nothing to read anyway
+    if (stat_buf.st_size > 0) {
+      void *mapping = mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_SHARED,
+                           db_fd_, 0);
+      if (mapping == MAP_FAILED) {
+        close(db_fd_);
+        throw Exception("cannot map database file " + db_file + ": " +
+                        strerror(errno));
+      }
+      mapping_ = static_cast<char *>(mapping);
+      num_mapped_pages_ = stat_buf.st_size / PAGE_SIZE;
+    }
+    // without the map every page of the file counts as allocated
+    MarkAllocated(0, GetNumPages());
+    return;
+  }
+  LoadFreeSpaceMap(is_new_file);
+  // the blocks past the end of the file, if any, are preallocated again
+  preallocated_end_ = GetNumPages();
 }
 
-DiskManager::~DiskManager() { db_io_.close(); }
+DiskManager::~DiskManager() {
+  // waits for the asynchronous requests still in flight
+  delete async_io_.load();
+  if (mapping_ != nullptr)
+    munmap(mapping_, num_mapped_pages_ * PAGE_SIZE);
+  close(db_fd_);
+  SaveFreeSpaceMap();
+  if (fsm_fd_ >= 0)
+    close(fsm_fd_);
+  // the slots left since the last Sync are found free on the next open
+  if (location_fd_ >= 0) {
+    SaveLocationMap();
+    close(location_fd_);
+  }
+}
 
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file, from a stamped
+ * copy
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  if (io_mode_ == DISK_IO_MMAP)
+    throw Exception("database file " + file_name_ + " is mapped read-only");
+  if (compression_ != DISK_COMPRESSION_NONE) {
+    WriteCompressedPage(page_id, page_data);
+    return;
+  }
+  alignas(DIRECT_IO_ALIGNMENT) char buffer[PAGE_SIZE];
+  memcpy(buffer, page_data, PAGE_DATA_SIZE);
+  StampChecksum(buffer);
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
   // check for I/O error
-  if (db_io_.bad()) {
+  if (!WriteAll(db_fd_, buffer, PAGE_SIZE, offset)) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  ExtendFileSize(offset + PAGE_SIZE);
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Read the contents of the specified page into the given memory area. A page
+ * past the end of the file reads as zeros, pread tells without a stat
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset >= GetFileSize()) {
-    LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
+  ReadPages(page_id, 1, page_data);
+}
+
+/**
+ * Read num_pages pages starting at first_page_id into data, which must hold
+ * num_pages * PAGE_SIZE bytes. The part past the end of the file is zeroed
+ */
+void DiskManager::ReadPages(page_id_t first_page_id, size_t num_pages,
+                            char *data) {
+  // the pages are not next to each other in the file
+  if (compression_ != DISK_COMPRESSION_NONE) {
+    for (size_t i = 0; i < num_pages; ++i)
+      ReadCompressedPage(first_page_id + i, data + i * PAGE_SIZE);
+    return;
+  }
+  off_t offset = static_cast<off_t>(first_page_id) * PAGE_SIZE;
+  size_t size = num_pages * PAGE_SIZE;
+  std::unique_ptr<char, decltype(&free)> bounce(nullptr, &free);
+  char *buffer = data;
+  if (NeedsBounce(data)) {
+    bounce.reset(AllocateAligned(size));
+    buffer = bounce.get();
+  }
+  size_t read_count = ReadAll(db_fd_, buffer, size, offset);
+  if (read_count < size) {
+    LOG_DEBUG("Read less than %zu pages", num_pages);
+    memset(buffer + read_count, 0, size - read_count);
+  }
+  if (bounce != nullptr)
+    memcpy(data, buffer, size);
+  // a page cut short is zero-filled and fails too
+  for (size_t i = 0; i < num_pages; ++i) {
+    if (!VerifyChecksum(data + i * PAGE_SIZE))
+      throw PageCorruptionException(first_page_id + i,
+                                    "of " + file_name_ + " fails its checksum");
+  }
+}
+
+/**
+ * Write num_pages consecutive pages starting at first_page_id, page i taken
+ * from pages[i]. The stamped copies of up to IOV_MAX pages are gathered in
+ * one buffer and written with one call
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const char *const *pages,
+                             size_t num_pages) {
+  if (io_mode_ == DISK_IO_MMAP)
+    throw Exception("database file " + file_name_ + " is mapped read-only");
+  if (num_pages == 0)
+    return;
+  if (compression_ != DISK_COMPRESSION_NONE) {
+    for (size_t i = 0; i < num_pages; ++i)
+      WriteCompressedPage(first_page_id + i, pages[i]);
+    return;
+  }
+  size_t max_count = std::min<size_t>(num_pages, IOV_MAX);
+  std::unique_ptr<char, decltype(&free)> buffer(
+      AllocateAligned(max_count * PAGE_SIZE), &free);
+  for (size_t done = 0; done < num_pages; done += max_count) {
+    size_t count = std::min(num_pages - done, max_count);
+    CopyStamped(pages + done, count, buffer.get());
+    off_t offset = static_cast<off_t>(first_page_id + done) * PAGE_SIZE;
+    if (!WriteAll(db_fd_, buffer.get(), count * PAGE_SIZE, offset)) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    ExtendFileSize(offset + count * PAGE_SIZE);
+  }
+}
+
+/**
+ * Force the writes of the file to disk, then write the free space map and
+ * force it as well. With compression the location map follows, and once it
+ * is on disk the slots left before the data was forced are free. Like the
+ * writes themselves, Sync covers the writes that returned before it
+ */
+void DiskManager::Sync() {
+  std::vector<PageLocation> released;
+  if (compression_ != DISK_COMPRESSION_NONE) {
+    std::lock_guard<std::mutex> guard(location_mutex_);
+    released.swap(released_slots_);
+  }
+  if (fsync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+  {
+    std::lock_guard<std::mutex> guard(allocation_mutex_);
+    SaveFreeSpaceMap();
+    if (fsm_fd_ >= 0 && fsync(fsm_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing the free space map");
+    }
+  }
+  if (compression_ == DISK_COMPRESSION_NONE)
+    return;
+  std::lock_guard<std::mutex> guard(location_mutex_);
+  if (!SaveLocationMap() || fsync(location_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the location map");
+    // the map on disk may still point to them
+    released_slots_.insert(released_slots_.end(), released.begin(),
+                           released.end());
+    return;
+  }
+  for (const PageLocation &location : released) {
+    PunchSlots(db_fd_, location.first_slot, location.num_slots);
+    FreeSlots(location.first_slot, location.num_slots);
+  }
+}
+
+/**
+ * Read a page in the background, a page past the end of the file reads as
+ * zeros like with ReadPage
+ */
+void DiskManager::ReadPageAsync(page_id_t page_id, char *page_data,
+                                std::function<void(bool)> callback) {
+  if (compression_ != DISK_COMPRESSION_NONE) {
+    ReadCompressedPageAsync(page_id, page_data, callback);
+    return;
+  }
+  AsyncIORequest *request = new AsyncIORequest();
+  request->op = ASYNC_IO_READ;
+  request->fd = db_fd_;
+  request->offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  char *bounce = NeedsBounce(page_data) ? AllocateAligned(PAGE_SIZE) : nullptr;
+  request->iov.push_back({bounce != nullptr ? bounce : page_data, PAGE_SIZE});
+  request->callback = [page_id, page_data, bounce, callback](ssize_t result) {
+    if (result < 0) {
+      LOG_DEBUG("I/O error while reading");
+      free(bounce);
+      callback(false);
+      return;
+    }
+    if (bounce != nullptr) {
+      memcpy(page_data, bounce, result);
+      free(bounce);
+    }
+    if (static_cast<size_t>(result) < PAGE_SIZE)
+      memset(page_data + result, 0, PAGE_SIZE - result);
+    if (!VerifyChecksum(page_data)) {
+      LOG_WARN("page %d fails its checksum", page_id);
+      callback(false);
+      return;
+    }
+    callback(true);
+  };
+  GetAsyncIOEngine()->Submit(request);
+}
+
+void DiskManager::WritePageAsync(page_id_t page_id, const char *page_data,
+                                 std::function<void(bool)> callback) {
+  WritePagesAsync(page_id, &page_data, 1, callback);
+}
+
+/**
+ * Write consecutive pages in the background, in requests of at most IOV_MAX
+ * pages, or of one page with compression, that may complete in any order.
+ * callback runs once all of them did. The pages are copied and stamped, and
+ * compressed, before the call returns
+ */
+void DiskManager::WritePagesAsync(page_id_t first_page_id,
+                                  const char *const *pages, size_t num_pages,
+                                  std::function<void(bool)> callback) {
+  if (num_pages == 0) {
+    callback(true);
+    return;
+  }
+  struct Progress {
+    std::atomic<size_t> num_requests;
+    std::atomic<bool> ok{true};
+  };
+  // a request from a buffer of its own, the file covers end once it is done
+  struct Write {
+    off_t offset;
+    char *buffer;
+    size_t size;
+    size_t end;
+  };
+  std::vector<Write> writes;
+  if (compression_ == DISK_COMPRESSION_NONE) {
+    for (size_t done = 0; done < num_pages; done += IOV_MAX) {
+      size_t count = std::min<size_t>(num_pages - done, IOV_MAX);
+      off_t offset = static_cast<off_t>(first_page_id + done) * PAGE_SIZE;
+      size_t size = count * PAGE_SIZE;
+      char *buffer = AllocateAligned(size);
+      CopyStamped(pages + done, count, buffer);
+      writes.push_back({offset, buffer, size, offset + size});
+    }
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    for (size_t i = 0; i < num_pages; ++i) {
+      char *buffer = AllocateAligned(PAGE_SIZE);
+      uint32_t num_slots = CompressPage(pages[i], buffer);
+      uint32_t first_slot = PlacePage(first_page_id + i, num_slots);
+      writes.push_back(
+          {static_cast<off_t>(first_slot) * COMPRESSED_SLOT_SIZE, buffer,
+           num_slots * COMPRESSED_SLOT_SIZE,
+           static_cast<size_t>(first_page_id + i + 1) * PAGE_SIZE});
     }
   }
+  std::shared_ptr<Progress> progress = std::make_shared<Progress>();
+  progress->num_requests = writes.size();
+  AsyncIOEngine *engine = GetAsyncIOEngine();
+  for (const Write &write : writes) {
+    AsyncIORequest *request = new AsyncIORequest();
+    request->op = ASYNC_IO_WRITE;
+    request->fd = db_fd_;
+    request->offset = write.offset;
+    request->iov.push_back({write.buffer, write.size});
+    request->callback = [this, write, progress, callback](ssize_t result) {
+      free(write.buffer);
+      if (result == static_cast<ssize_t>(write.size)) {
+        ExtendFileSize(write.end);
+      } else {
+        LOG_DEBUG("I/O error while writing");
+        progress->ok = false;
+      }
+      if (--progress->num_requests == 0)
+        callback(progress->ok);
+    };
+    engine->Submit(request);
+  }
+}
+
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id,
+                                             char *page_data) {
+  std::shared_ptr<std::promise<bool>> done =
+      std::make_shared<std::promise<bool>>();
+  std::future<bool> future = done->get_future();
+  ReadPageAsync(page_id, page_data, [done](bool ok) { done->set_value(ok); });
+  return future;
+}
+
+std::future<bool> DiskManager::WritePageAsync(page_id_t page_id,
+                                              const char *page_data) {
+  return WritePagesAsync(page_id, &page_data, 1);
+}
+
+std::future<bool> DiskManager::WritePagesAsync(page_id_t first_page_id,
+                                               const char *const *pages,
+                                               size_t num_pages) {
+  std::shared_ptr<std::promise<bool>> done =
+      std::make_shared<std::promise<bool>>();
+  std::future<bool> future = done->get_future();
+  WritePagesAsync(first_page_id, pages, num_pages,
+                  [done](bool ok) { done->set_value(ok); });
+  return future;
+}
+
+/**
+ * The checksum covers the data part of the page, it is kept in the trailer
+ * in little-endian byte order
+ */
+void DiskManager::StampChecksum(char *page_data) {
+  uint32_t crc = CRC32C::Checksum(page_data, PAGE_DATA_SIZE);
+  for (int i = 0; i < PAGE_CHECKSUM_SIZE; ++i)
+    page_data[PAGE_DATA_SIZE + i] = static_cast<char>(crc >> (8 * i));
+}
+
+bool DiskManager::VerifyChecksum(const char *page_data) {
+  uint32_t crc = CRC32C::Checksum(page_data, PAGE_DATA_SIZE);
+  const unsigned char *trailer =
+      reinterpret_cast<const unsigned char *>(page_data + PAGE_DATA_SIZE);
+  uint32_t stored = 0;
+  for (int i = 0; i < PAGE_CHECKSUM_SIZE; ++i)
+    stored |= uint32_t(trailer[i]) << (8 * i);
+  if (stored == crc)
+    return true;
+  // rare, only pages that are damaged or were never written get here
+  for (size_t i = 0; i < PAGE_SIZE; ++i) {
+    if (page_data[i] != 0)
+      return false;
+  }
+  return true;
+}
+
+AsyncIOBackend DiskManager::GetAsyncIOBackend() {
+  return GetAsyncIOEngine()->GetBackend();
+}
+
+/**
+ * Pass an access hint for pages of the mapping on to the kernel, the part
+ * past the mapped file is ignored
+ */
+void DiskManager::AdvisePages(page_id_t first_page_id, size_t num_pages,
+                              DiskAdvice advice) {
+  if (first_page_id < 0 ||
+      static_cast<size_t>(first_page_id) >= num_mapped_pages_)
+    return;
+  size_t begin = static_cast<size_t>(first_page_id) * PAGE_SIZE;
+  size_t end =
+      std::min(first_page_id + num_pages, num_mapped_pages_) * PAGE_SIZE;
+  // madvise wants the start aligned to the pages of the system
+  begin -= begin % sysconf(_SC_PAGESIZE);
+  int flag = MADV_NORMAL;
+  switch (advice) {
+  case DISK_ADVICE_NORMAL:
+    flag = MADV_NORMAL;
+    break;
+  case DISK_ADVICE_SEQUENTIAL:
+    flag = MADV_SEQUENTIAL;
+    break;
+  case DISK_ADVICE_RANDOM:
+    flag = MADV_RANDOM;
+    break;
+  case DISK_ADVICE_WILLNEED:
+    flag = MADV_WILLNEED;
+    break;
+  }
+  if (madvise(mapping_ + begin, end - begin, flag) != 0) {
+    LOG_DEBUG("madvise failed: %s", strerror(errno));
+  }
 }
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Near a hint, the extent of the hint is searched from the hint on and then
+ * from its start. If it is full, the allocation continues at the end of the
+ * file if that lies within the extent, else at the start of a new extent,
+ * and the pages skipped become free. Without a hint the whole map is
+ * searched, map pages without free pages are skipped as a whole
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(page_id_t hint) {
+  if (io_mode_ == DISK_IO_MMAP)
+    throw Exception("database file " + file_name_ + " is mapped read-only");
+  std::lock_guard<std::mutex> guard(allocation_mutex_);
+  page_id_t page_id = INVALID_PAGE_ID;
+  if (hint >= 0 && hint < next_page_id_) {
+    page_id_t extent_begin = hint / EXTENT_PAGES * EXTENT_PAGES;
+    page_id_t extent_end = extent_begin + EXTENT_PAGES;
+    page_id = FindFreePage(hint, std::min(extent_end, next_page_id_));
+    if (page_id == INVALID_PAGE_ID)
+      page_id = FindFreePage(extent_begin, hint);
+    if (page_id == INVALID_PAGE_ID && next_page_id_ >= extent_end)
+      page_id = (next_page_id_ + EXTENT_PAGES - 1) / EXTENT_PAGES *
+                EXTENT_PAGES;
+  } else if (hint < 0 && num_free_pages_ > 0) {
+    page_id = FindFreePage(0, next_page_id_);
+  }
+  if (page_id == INVALID_PAGE_ID)
+    page_id = next_page_id_;
+  if (page_id >= next_page_id_)
+    GrowAllocation(page_id + 1);
+  free_counts_[page_id / FSM_PAGE_BITS]--;
+  num_free_pages_--;
+  GetBitmapWord(page_id) |= GetBitmapMask(page_id);
+  dirty_map_pages_[page_id / FSM_PAGE_BITS] = true;
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (io_mode_ == DISK_IO_MMAP)
+    throw Exception("database file " + file_name_ + " is mapped read-only");
+  std::lock_guard<std::mutex> guard(allocation_mutex_);
+  if (page_id < 0 || page_id >= next_page_id_ ||
+      (GetBitmapWord(page_id) & GetBitmapMask(page_id)) == 0)
+    return;
+  GetBitmapWord(page_id) &= ~GetBitmapMask(page_id);
+  free_counts_[page_id / FSM_PAGE_BITS]++;
+  num_free_pages_++;
+  dirty_map_pages_[page_id / FSM_PAGE_BITS] = true;
+  if (compression_ == DISK_COMPRESSION_NONE)
+    return;
+  std::lock_guard<std::mutex> location_guard(location_mutex_);
+  if (static_cast<size_t>(page_id) < locations_.size()) {
+    ReleaseSlots(locations_[page_id]);
+    locations_[page_id] = {0, 0};
+    dirty_location_pages_[page_id / (PAGE_SIZE / sizeof(PageLocation))] =
+        true;
+  }
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(allocation_mutex_);
+  return page_id >= 0 && page_id < next_page_id_ &&
+         (GetBitmapWord(page_id) & GetBitmapMask(page_id)) != 0;
+}
+
+size_t DiskManager::GetNumFreePages() {
+  std::lock_guard<std::mutex> guard(allocation_mutex_);
+  return num_free_pages_;
+}
+
+size_t DiskManager::GetStoredSize() {
+  if (compression_ == DISK_COMPRESSION_NONE)
+    return static_cast<size_t>(GetNumPages()) * PAGE_SIZE;
+  std::lock_guard<std::mutex> guard(location_mutex_);
+  return num_used_slots_ * COMPRESSED_SLOT_SIZE;
 }
 
 /**
- * Private helper function to get disk file size
+ * Number of whole pages in the disk file, with compression the pages the
+ * location map covers
+ */
+page_id_t DiskManager::GetNumPages() { return file_size_ / PAGE_SIZE; }
+
+/*
+ * Private helper: copy count pages into buffer, one after the other, and
+ * stamp the copies
+ */
+void DiskManager::CopyStamped(const char *const *pages, size_t count,
+                              char *buffer) {
+  for (size_t i = 0; i < count; ++i) {
+    char *page = buffer + i * PAGE_SIZE;
+    memcpy(page, pages[i], PAGE_DATA_SIZE);
+    StampChecksum(page);
+  }
+}
+
+/*
+ * Private helper: stamp a copy of the page and compress it into slots, which
+ * holds PAGE_SIZE bytes, the unused part of the last slot zeroed. Return the
+ * number of slots taken, MAX_PAGE_SLOTS for a page stored as is
+ */
+uint32_t DiskManager::CompressPage(const char *page_data, char *slots) {
+  char page[PAGE_SIZE];
+  memcpy(page, page_data, PAGE_DATA_SIZE);
+  StampChecksum(page);
+  // it has to save a slot at least
+  size_t size = LZCodec::Compress(page, PAGE_SIZE,
+                                  slots + COMPRESSED_HEADER_SIZE,
+                                  PAGE_SIZE - COMPRESSED_SLOT_SIZE -
+                                      COMPRESSED_HEADER_SIZE);
+  if (size == 0) {
+    memcpy(slots, page, PAGE_SIZE);
+    return MAX_PAGE_SLOTS;
+  }
+  slots[0] = static_cast<char>(size);
+  slots[1] = static_cast<char>(size >> 8);
+  size += COMPRESSED_HEADER_SIZE;
+  uint32_t num_slots =
+      (size + COMPRESSED_SLOT_SIZE - 1) / COMPRESSED_SLOT_SIZE;
+  memset(slots + size, 0, num_slots * COMPRESSED_SLOT_SIZE - size);
+  return num_slots;
+}
+
+/*
+ * Private helper: the page stored in num_slots slots, return false if they
+ * do not hold one. The checksum is left to the caller
+ */
+bool DiskManager::ExpandPage(const char *slots, uint32_t num_slots,
+                             char *page_data) {
+  if (num_slots == MAX_PAGE_SLOTS) {
+    memcpy(page_data, slots, PAGE_SIZE);
+    return true;
+  }
+  const unsigned char *header = reinterpret_cast<const unsigned char *>(slots);
+  size_t size = header[0] | header[1] << 8;
+  if (size + COMPRESSED_HEADER_SIZE > num_slots * COMPRESSED_SLOT_SIZE)
+    return false;
+  return LZCodec::Decompress(slots + COMPRESSED_HEADER_SIZE, size, page_data,
+                             PAGE_SIZE);
+}
+
+/*
+ * Private helper: WritePage with compression. The slots are placed before
+ * they are written
+ */
+void DiskManager::WriteCompressedPage(page_id_t page_id,
+                                      const char *page_data) {
+  alignas(DIRECT_IO_ALIGNMENT) char slots[PAGE_SIZE];
+  uint32_t num_slots = CompressPage(page_data, slots);
+  uint32_t first_slot = PlacePage(page_id, num_slots);
+  if (!WriteAll(db_fd_, slots, num_slots * COMPRESSED_SLOT_SIZE,
+                static_cast<off_t>(first_slot) * COMPRESSED_SLOT_SIZE)) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  ExtendFileSize(static_cast<size_t>(page_id + 1) * PAGE_SIZE);
+}
+
+/*
+ * Private helper: ReadPage with compression, a page never written reads as
+ * zeros
+ */
+void DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  PageLocation location = GetLocation(page_id);
+  if (location.num_slots == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  alignas(DIRECT_IO_ALIGNMENT) char slots[PAGE_SIZE];
+  size_t size = location.num_slots * COMPRESSED_SLOT_SIZE;
+  size_t read_count =
+      ReadAll(db_fd_, slots, size,
+              static_cast<off_t>(location.first_slot) * COMPRESSED_SLOT_SIZE);
+  // fails to expand or its checksum
+  if (read_count < size) {
+    LOG_DEBUG("Read less than %u slots", location.num_slots);
+    memset(slots + read_count, 0, size - read_count);
+  }
+  if (!ExpandPage(slots, location.num_slots, page_data))
+    throw PageCorruptionException(page_id, "of " + file_name_ +
+                                               " fails to decompress");
+  if (!VerifyChecksum(page_data))
+    throw PageCorruptionException(page_id,
+                                  "of " + file_name_ + " fails its checksum");
+}
+
+/*
+ * Private helper: ReadPageAsync with compression. The slots are read into a
+ * buffer of their own and expanded by the I/O thread
+ */
+void DiskManager::ReadCompressedPageAsync(page_id_t page_id, char *page_data,
+                                          std::function<void(bool)> callback) {
+  PageLocation location = GetLocation(page_id);
+  if (location.num_slots == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    callback(true);
+    return;
+  }
+  size_t size = location.num_slots * COMPRESSED_SLOT_SIZE;
+  char *slots = AllocateAligned(size);
+  AsyncIORequest *request = new AsyncIORequest();
+  request->op = ASYNC_IO_READ;
+  request->fd = db_fd_;
+  request->offset =
+      static_cast<off_t>(location.first_slot) * COMPRESSED_SLOT_SIZE;
+  request->iov.push_back({slots, size});
+  request->callback = [page_id, page_data, location, slots, size,
+                       callback](ssize_t result) {
+    if (result < 0) {
+      LOG_DEBUG("I/O error while reading");
+      free(slots);
+      callback(false);
+      return;
+    }
+    if (static_cast<size_t>(result) < size)
+      memset(slots + result, 0, size - result);
+    bool ok = ExpandPage(slots, location.num_slots, page_data) &&
+              VerifyChecksum(page_data);
+    free(slots);
+    if (!ok) {
+      LOG_WARN("page %d fails to decompress or its checksum", page_id);
+    }
+    callback(ok);
+  };
+  GetAsyncIOEngine()->Submit(request);
+}
+
+/*
+ * Private helper: the file is at least size bytes long now
  */
-int DiskManager::GetFileSize() {
+void DiskManager::ExtendFileSize(size_t size) {
+  size_t file_size = file_size_;
+  while (file_size < size &&
+         !file_size_.compare_exchange_weak(file_size, size)) {
+  }
+}
+
+/*
+ * Private helper: the engine of the asynchronous calls, set up on first use
+ */
+AsyncIOEngine *DiskManager::GetAsyncIOEngine() {
+  AsyncIOEngine *engine = async_io_;
+  if (engine != nullptr)
+    return engine;
+  std::lock_guard<std::mutex> guard(async_io_mutex_);
+  if (async_io_ == nullptr)
+    async_io_ = AsyncIOEngine::Create(async_io_backend_);
+  return async_io_;
+}
+
+// first bytes of the header page of a free space map
+struct FreeSpaceMapHeader {
+  uint32_t magic;
+  page_id_t next_page_id;
+};
+static const uint32_t FSM_MAGIC = 0x6d736621;
+
+/*
+ * Private helper: rebuild the allocation state from the free space map, if
+ * there is one, and the size of the file. A map next to a new database file
+ * was left behind by a deleted one and is dropped
+ */
+void DiskManager::LoadFreeSpaceMap(bool is_new_file) {
+  next_page_id_ = 0;
+  fsm_fd_ = open(fsm_file_name_.c_str(), O_RDWR);
   struct stat stat_buf;
-  int rc = stat(file_name_.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+  FreeSpaceMapHeader header;
+  bool has_map = fsm_fd_ >= 0 && !is_new_file &&
+                 fstat(fsm_fd_, &stat_buf) == 0 &&
+                 pread(fsm_fd_, &header, sizeof(header), 0) ==
+                     static_cast<ssize_t>(sizeof(header)) &&
+                 header.magic == FSM_MAGIC && header.next_page_id >= 0;
+  if (fsm_fd_ >= 0 && !has_map) {
+    // rewritten in full by the next SaveFreeSpaceMap
+    close(fsm_fd_);
+    fsm_fd_ = -1;
+    if (unlink(fsm_file_name_.c_str()) != 0) {
+      LOG_DEBUG("cannot remove the free space map");
+    }
+  }
+
+  if (has_map) {
+    size_t num_map_pages =
+        std::max<off_t>(stat_buf.st_size / PAGE_SIZE, 1) - 1;
+    bitmap_.resize(num_map_pages * FSM_PAGE_BITS / 64);
+    free_counts_.assign(num_map_pages, 0);
+    dirty_map_pages_.assign(num_map_pages, false);
+    size_t size = num_map_pages * PAGE_SIZE;
+    char *data = reinterpret_cast<char *>(bitmap_.data());
+    size_t read_count = 0;
+    while (read_count < size) {
+      ssize_t rc = pread(fsm_fd_, data + read_count, size - read_count,
+                         PAGE_SIZE + read_count);
+      if (rc < 0 && errno == EINTR)
+        continue;
+      if (rc <= 0)
+        break;
+      read_count += rc;
+    }
+    // bits of a map page that was never written are clear, no page past
+    // the map can be allocated
+    next_page_id_ = std::min<size_t>(header.next_page_id, bitmap_.size() * 64);
+    for (page_id_t first = 0; first < next_page_id_; first += 64) {
+      size_t num_bits = std::min<page_id_t>(64, next_page_id_ - first);
+      uint64_t word =
+          GetBitmapWord(first) & (~uint64_t(0) >> (64 - num_bits));
+      size_t num_free = num_bits - __builtin_popcountll(word);
+      free_counts_[first / FSM_PAGE_BITS] += num_free;
+      num_free_pages_ += num_free;
+    }
+    saved_next_page_id_ = next_page_id_;
+  }
+  // written since, or without a map at all
+  MarkAllocated(next_page_id_, GetNumPages());
+}
+
+/*
+ * Private helper: allocate the pages in [begin, end), all past
+ * next_page_id_. Caller must hold allocation_mutex_ unless the DiskManager
+ * is not shared yet
+ */
+void DiskManager::MarkAllocated(page_id_t begin, page_id_t end) {
+  if (begin >= end)
+    return;
+  ResizeMap(end);
+  size_t num_map_pages = free_counts_.size();
+  for (page_id_t page_id = begin; page_id < end; ++page_id) {
+    // whole words at once
+    if (page_id % 64 == 0 && end - page_id >= 64) {
+      GetBitmapWord(page_id) = ~uint64_t(0);
+      page_id += 63;
+      continue;
+    }
+    GetBitmapWord(page_id) |= GetBitmapMask(page_id);
+  }
+  for (size_t i = begin / FSM_PAGE_BITS; i < num_map_pages; ++i)
+    dirty_map_pages_[i] = true;
+  next_page_id_ = end;
+}
+
+/*
+ * Private helper: move the end of the allocated pages to end, the pages in
+ * between are free. The file is preallocated up to the end of the extent of
+ * the last page, without changing its size, so GetNumPages still counts the
+ * pages written. Caller must hold allocation_mutex_
+ */
+void DiskManager::GrowAllocation(page_id_t end) {
+  ResizeMap(end);
+  for (page_id_t page_id = next_page_id_; page_id < end; ++page_id)
+    free_counts_[page_id / FSM_PAGE_BITS]++;
+  num_free_pages_ += end - next_page_id_;
+  next_page_id_ = end;
+  // the compressed pages are not where their page ids say
+  if (compression_ == DISK_COMPRESSION_NONE && end > preallocated_end_) {
+    page_id_t extent_end =
+        (end + EXTENT_PAGES - 1) / EXTENT_PAGES * EXTENT_PAGES;
+    // an optimization only, not every file system supports it
+    if (fallocate(db_fd_, FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(preallocated_end_) * PAGE_SIZE,
+                  static_cast<off_t>(extent_end - preallocated_end_) *
+                      PAGE_SIZE) != 0) {
+      LOG_DEBUG("cannot preallocate: %s", strerror(errno));
+    }
+    preallocated_end_ = extent_end;
+  }
+}
+
+/*
+ * Private helper: make the map cover the pages below end. Caller must hold
+ * allocation_mutex_ unless the DiskManager is not shared yet
+ */
+void DiskManager::ResizeMap(page_id_t end) {
+  size_t num_map_pages = (end + FSM_PAGE_BITS - 1) / FSM_PAGE_BITS;
+  if (num_map_pages > free_counts_.size()) {
+    free_counts_.resize(num_map_pages, 0);
+    dirty_map_pages_.resize(num_map_pages, true);
+    bitmap_.resize(num_map_pages * FSM_PAGE_BITS / 64);
+  }
+}
+
+/*
+ * Private helper: write the map pages changed since the last call, and the
+ * header if the end of the allocated pages moved. The map file is only
+ * created once there is a free page. Caller must hold allocation_mutex_
+ * unless the DiskManager is not shared any more
+ */
+void DiskManager::SaveFreeSpaceMap() {
+  if (fsm_fd_ < 0) {
+    if (num_free_pages_ == 0)
+      return;
+    fsm_fd_ = open(fsm_file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fsm_fd_ < 0) {
+      LOG_DEBUG("cannot create the free space map");
+      return;
+    }
+    dirty_map_pages_.assign(dirty_map_pages_.size(), true);
+    saved_next_page_id_ = -1;
+  }
+  for (size_t i = 0; i < dirty_map_pages_.size(); ++i) {
+    if (!dirty_map_pages_[i])
+      continue;
+    const char *data =
+        reinterpret_cast<const char *>(&bitmap_[i * FSM_PAGE_BITS / 64]);
+    if (!WriteAll(fsm_fd_, data, PAGE_SIZE, (i + 1) * PAGE_SIZE)) {
+      LOG_DEBUG("I/O error while writing the free space map");
+      return;
+    }
+    dirty_map_pages_[i] = false;
+  }
+  // after the bits it covers
+  if (saved_next_page_id_ != next_page_id_) {
+    char page[PAGE_SIZE] = {};
+    FreeSpaceMapHeader header{FSM_MAGIC, next_page_id_};
+    memcpy(page, &header, sizeof(header));
+    if (!WriteAll(fsm_fd_, page, PAGE_SIZE, 0)) {
+      LOG_DEBUG("I/O error while writing the free space map");
+      return;
+    }
+    saved_next_page_id_ = next_page_id_;
+  }
+}
+
+/*
+ * Private helper: the first free page in [begin, end), or INVALID_PAGE_ID.
+ * Caller must hold allocation_mutex_
+ */
+page_id_t DiskManager::FindFreePage(page_id_t begin, page_id_t end) {
+  page_id_t page_id = begin;
+  while (page_id < end) {
+    size_t map_page = page_id / FSM_PAGE_BITS;
+    if (free_counts_[map_page] == 0) {
+      page_id = (map_page + 1) * FSM_PAGE_BITS;
+      continue;
+    }
+    // the clear bits from page_id on
+    uint64_t free_bits =
+        ~GetBitmapWord(page_id) & ~(GetBitmapMask(page_id) - 1);
+    if (free_bits != 0) {
+      page_id_t found = page_id / 64 * 64 + __builtin_ctzll(free_bits);
+      return found < end ? found : INVALID_PAGE_ID;
+    }
+    page_id = (page_id / 64 + 1) * 64;
+  }
+  return INVALID_PAGE_ID;
+}
+
+// first bytes of the header page of a location map
+struct LocationMapHeader {
+  uint32_t magic;
+  uint32_t num_pages;
+};
+static const uint32_t LOCATION_MAP_MAGIC = 0x636f6c21;
+
+/*
+ * Private helper: with compression, load the location map and find the
+ * slots no page takes, they are punched out of the file again in case a
+ * Sync did not get to it. Without, make sure the file was not written
+ * compressed. Throw if the map does not match the file
+ */
+void DiskManager::LoadLocationMap(bool is_new_file) {
+  if (compression_ == DISK_COMPRESSION_NONE) {
+    if (access(location_file_name_.c_str(), F_OK) != 0)
+      return;
+    if (!is_new_file)
+      throw Exception("database file " + file_name_ + " was written "
+                      "compressed");
+    // left behind by a deleted database file
+    if (unlink(location_file_name_.c_str()) != 0) {
+      LOG_DEBUG("cannot remove the location map");
+    }
+    return;
+  }
+  location_fd_ = open(location_file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (location_fd_ < 0)
+    throw Exception("cannot open location map " + location_file_name_ +
+                    ": " + strerror(errno));
+  free_slots_.assign(MAX_PAGE_SLOTS + 1, std::vector<uint32_t>());
+  // a slot cut short is refused by the caller
+  next_slot_ = file_size_ / COMPRESSED_SLOT_SIZE;
+  LocationMapHeader header;
+  bool has_map = !is_new_file &&
+                 pread(location_fd_, &header, sizeof(header), 0) ==
+                     static_cast<ssize_t>(sizeof(header)) &&
+                 header.magic == LOCATION_MAP_MAGIC;
+  if (!has_map) {
+    if (file_size_ != 0) {
+      close(location_fd_);
+      throw Exception("database file " + file_name_ +
+                      " was not written compressed");
+    }
+    // written in full by the next SaveLocationMap
+    if (ftruncate(location_fd_, 0) != 0) {
+      LOG_DEBUG("cannot truncate the location map");
+    }
+    return;
+  }
+
+  const size_t per_page = PAGE_SIZE / sizeof(PageLocation);
+  locations_.resize(header.num_pages);
+  dirty_location_pages_.assign((header.num_pages + per_page - 1) / per_page,
+                               false);
+  size_t size = header.num_pages * sizeof(PageLocation);
+  size_t read_count = ReadAll(
+      location_fd_, reinterpret_cast<char *>(locations_.data()), size,
+      PAGE_SIZE);
+  // never written, so never moved either
+  memset(reinterpret_cast<char *>(locations_.data()) + read_count, 0,
+         size - read_count);
+  saved_num_locations_ = header.num_pages;
+  // every slot taken once at most, by a page within the file
+  std::vector<bool> taken(next_slot_, false);
+  for (const PageLocation &location : locations_) {
+    if (location.num_slots == 0)
+      continue;
+    if (location.num_slots > MAX_PAGE_SLOTS ||
+        location.first_slot + location.num_slots > next_slot_) {
+      close(location_fd_);
+      throw Exception("location map " + location_file_name_ +
+                      " does not match the database file");
+    }
+    for (uint32_t i = 0; i < location.num_slots; ++i) {
+      if (taken[location.first_slot + i]) {
+        close(location_fd_);
+        throw Exception("location map " + location_file_name_ +
+                        " does not match the database file");
+      }
+      taken[location.first_slot + i] = true;
+    }
+    num_used_slots_ += location.num_slots;
+  }
+  for (uint32_t slot = 0; slot < next_slot_;) {
+    if (taken[slot]) {
+      ++slot;
+      continue;
+    }
+    uint32_t end = slot;
+    while (end < next_slot_ && !taken[end])
+      ++end;
+    PunchSlots(db_fd_, slot, end - slot);
+    for (; slot < end; slot += MAX_PAGE_SLOTS)
+      FreeSlots(slot, std::min(end - slot, MAX_PAGE_SLOTS));
+  }
+  file_size_ = locations_.size() * PAGE_SIZE;
+}
+
+/*
+ * Private helper: where page_id is stored, no slots if it was never written
+ */
+DiskManager::PageLocation DiskManager::GetLocation(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(location_mutex_);
+  if (page_id < 0 || static_cast<size_t>(page_id) >= locations_.size())
+    return {0, 0};
+  return locations_[page_id];
+}
+
+/*
+ * Private helper: the first of num_slots slots to write page_id to, the
+ * slots it takes now if there are as many, else new ones
+ */
+uint32_t DiskManager::PlacePage(page_id_t page_id, uint32_t num_slots) {
+  std::lock_guard<std::mutex> guard(location_mutex_);
+  const size_t per_page = PAGE_SIZE / sizeof(PageLocation);
+  if (static_cast<size_t>(page_id) >= locations_.size()) {
+    locations_.resize(page_id + 1, {0, 0});
+    dirty_location_pages_.resize((page_id + per_page) / per_page, true);
+  }
+  PageLocation &location = locations_[page_id];
+  if (location.num_slots == num_slots)
+    return location.first_slot;
+  ReleaseSlots(location);
+  location = {AllocateSlots(num_slots), num_slots};
+  num_used_slots_ += num_slots;
+  dirty_location_pages_[page_id / per_page] = true;
+  return location.first_slot;
+}
+
+/*
+ * Private helper: the first of num_slots free slots, from the free runs of
+ * that length, else split from a longer one, else at the end of the file.
+ * Caller must hold location_mutex_
+ */
+uint32_t DiskManager::AllocateSlots(uint32_t num_slots) {
+  for (uint32_t length = num_slots; length <= MAX_PAGE_SLOTS; ++length) {
+    std::vector<uint32_t> &runs = free_slots_[length];
+    if (runs.empty())
+      continue;
+    uint32_t first_slot = runs.back();
+    runs.pop_back();
+    if (length > num_slots)
+      FreeSlots(first_slot + num_slots, length - num_slots);
+    return first_slot;
+  }
+  uint32_t first_slot = next_slot_;
+  next_slot_ += num_slots;
+  return first_slot;
+}
+
+/*
+ * Private helper: the slots of a page that moves or is deallocated, free
+ * after the next Sync. Caller must hold location_mutex_
+ */
+void DiskManager::ReleaseSlots(PageLocation location) {
+  if (location.num_slots == 0)
+    return;
+  released_slots_.push_back(location);
+  num_used_slots_ -= location.num_slots;
+}
+
+/*
+ * Private helper: make a run of free slots available to AllocateSlots.
+ * Caller must hold location_mutex_ unless the DiskManager is not shared yet
+ */
+void DiskManager::FreeSlots(uint32_t first_slot, uint32_t num_slots) {
+  free_slots_[num_slots].push_back(first_slot);
+}
+
+/*
+ * Private helper: write the map pages changed since the last call, and the
+ * header if the number of pages changed, return false on an I/O error.
+ * Caller must hold location_mutex_ unless the DiskManager is not shared any
+ * more
+ */
+bool DiskManager::SaveLocationMap() {
+  const size_t per_page = PAGE_SIZE / sizeof(PageLocation);
+  for (size_t i = 0; i < dirty_location_pages_.size(); ++i) {
+    if (!dirty_location_pages_[i])
+      continue;
+    // the last one is cut short in memory
+    char page[PAGE_SIZE] = {};
+    size_t count = std::min(per_page, locations_.size() - i * per_page);
+    memcpy(page, &locations_[i * per_page], count * sizeof(PageLocation));
+    if (!WriteAll(location_fd_, page, PAGE_SIZE, (i + 1) * PAGE_SIZE)) {
+      LOG_DEBUG("I/O error while writing the location map");
+      return false;
+    }
+    dirty_location_pages_[i] = false;
+  }
+  // after the locations it covers
+  if (saved_num_locations_ != locations_.size()) {
+    char page[PAGE_SIZE] = {};
+    LocationMapHeader header{LOCATION_MAP_MAGIC,
+                             static_cast<uint32_t>(locations_.size())};
+    memcpy(page, &header, sizeof(header));
+    if (!WriteAll(location_fd_, page, PAGE_SIZE, 0)) {
+      LOG_DEBUG("I/O error while writing the location map");
+      return false;
+    }
+    saved_num_locations_ = locations_.size();
+  }
+  return true;
 }
 
 } // namespace cmudb
@@ -1,3 +1,4 @@
+#include <functional>
 #include <list>
 
 #include "hash/extendible_hash.h"
@@ -10,14 +11,17 @@ namespace cmudb {
  * array_size: fixed array size for each bucket
  */
 template <typename K, typename V>
-ExtendibleHash<K, V>::ExtendibleHash(size_t size) {}
+ExtendibleHash<K, V>::ExtendibleHash(size_t size)
+    : bucket_size_(size), global_depth_(0), num_buckets_(1) {
+  directory_.push_back(std::make_shared<Bucket>(0));
+}
 
 /*
  * helper function to calculate the hashing address of input key
  */
 template <typename K, typename V>
 size_t ExtendibleHash<K, V>::HashKey(const K &key) {
-  return 0;
+  return std::hash<K>()(key);
 }
 
 /*
@@ -26,7 +30,8 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetGlobalDepth() const {
-  return 0;
+  std::lock_guard<std::mutex> guard(latch_);
+  return global_depth_;
 }
 
 /*
@@ -35,7 +40,10 @@ int ExtendibleHash<K, V>::GetGlobalDepth() const {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-  return 0;
+  std::lock_guard<std::mutex> guard(latch_);
+  if (bucket_id < 0 || bucket_id >= static_cast<int>(directory_.size()))
+    return -1;
+  return directory_[bucket_id]->local_depth;
 }
 
 /*
@@ -43,7 +51,8 @@ int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetNumBuckets() const {
-  return 0;
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_buckets_;
 }
 
 /*
@@ -51,7 +60,13 @@ int ExtendibleHash<K, V>::GetNumBuckets() const {
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-  return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  auto &bucket = directory_[BucketIndex(key)];
+  auto it = bucket->items.find(key);
+  if (it == bucket->items.end())
+    return false;
+  value = it->second;
+  return true;
 }
 
 /*
@@ -60,7 +75,8 @@ bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Remove(const K &key) {
-  return false;
+  std::lock_guard<std::mutex> guard(latch_);
+  return directory_[BucketIndex(key)]->items.erase(key) > 0;
 }
 
 /*
@@ -69,7 +85,50 @@ bool ExtendibleHash<K, V>::Remove(const K &key) {
  * global depth
  */
 template <typename K, typename V>
-void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {}
+void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  std::shared_ptr<Bucket> bucket = directory_[BucketIndex(key)];
+  auto it = bucket->items.find(key);
+  if (it != bucket->items.end()) {
+    it->second = value;
+    return;
+  }
+  // keep splitting until the target bucket has room, all entries may hash to
+  // the same half more than once
+  while (bucket->items.size() >= bucket_size_) {
+    if (bucket->local_depth == global_depth_) {
+      size_t size = directory_.size();
+      for (size_t i = 0; i < size; ++i)
+        directory_.push_back(directory_[i]);
+      global_depth_++;
+    }
+    int mask = 1 << bucket->local_depth;
+    auto zero = std::make_shared<Bucket>(bucket->local_depth + 1);
+    auto one = std::make_shared<Bucket>(bucket->local_depth + 1);
+    for (auto &item : bucket->items) {
+      if (HashKey(item.first) & mask)
+        one->items.insert(item);
+      else
+        zero->items.insert(item);
+    }
+    for (size_t i = 0; i < directory_.size(); ++i) {
+      if (directory_[i] == bucket)
+        directory_[i] = (i & mask) ? one : zero;
+    }
+    num_buckets_++;
+    bucket = directory_[BucketIndex(key)];
+  }
+  bucket->items.insert(std::make_pair(key, value));
+}
+
+/*
+ * helper function to map a key onto its directory slot using the low
+ * global_depth_ bits of its hash, caller must hold latch_
+ */
+template <typename K, typename V>
+size_t ExtendibleHash<K, V>::BucketIndex(const K &key) {
+  return HashKey(key) & ((1 << global_depth_) - 1);
+}
 
 template class ExtendibleHash<page_id_t, Page *>;
 template class ExtendibleHash<Page *, std::list<Page *>::iterator>;
@@ -0,0 +1,120 @@
+/**
+ * page_table.cpp
+ */
+#include <cassert>
+
+#include "hash/page_table.h"
+
+namespace cmudb {
+
+/*
+ * constructor
+ * the table keeps at least twice as many slots as entries so probe sequences
+ * stay short
+ */
+PageTable::PageTable(size_t capacity)
+    : capacity_(capacity), num_entries_(0), num_tombstones_(0) {
+  size_t num_slots = 4;
+  while (num_slots < 2 * capacity_)
+    num_slots <<= 1;
+  mask_ = num_slots - 1;
+  slots_ = std::vector<Slot>(num_slots);
+}
+
+/*
+ * lock-free lookup, see file comment for the guarantees
+ */
+bool PageTable::Find(const page_id_t &page_id, Page *&page) {
+  for (size_t i = HashKey(page_id), n = 0; n <= mask_;
+       i = (i + 1) & mask_, ++n) {
+    page_id_t key = slots_[i].key.load(std::memory_order_acquire);
+    if (key == INVALID_PAGE_ID)
+      return false;
+    if (key == page_id) {
+      page = slots_[i].value.load(std::memory_order_acquire);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * delete <page_id,page> entry, leaves a tombstone so probe sequences through
+ * the slot stay intact. Writers must be serialized by the caller
+ */
+bool PageTable::Remove(const page_id_t &page_id) {
+  for (size_t i = HashKey(page_id), n = 0; n <= mask_;
+       i = (i + 1) & mask_, ++n) {
+    page_id_t key = slots_[i].key.load(std::memory_order_relaxed);
+    if (key == INVALID_PAGE_ID)
+      return false;
+    if (key == page_id) {
+      slots_[i].key.store(TOMBSTONE_PAGE_ID, std::memory_order_release);
+      num_entries_--;
+      num_tombstones_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * insert <page_id,page> entry, the value is published before the key so a
+ * concurrent Find never sees the key with a stale value of an empty slot.
+ * Writers must be serialized by the caller
+ */
+void PageTable::Insert(const page_id_t &page_id, Page *const &page) {
+  assert(page_id != INVALID_PAGE_ID && page_id != TOMBSTONE_PAGE_ID);
+  // tombstones only ever grow until the table is rebuilt
+  if (num_entries_ + num_tombstones_ + 1 > (mask_ + 1) * 3 / 4)
+    Rebuild();
+
+  size_t target = mask_ + 1;
+  for (size_t i = HashKey(page_id), n = 0; n <= mask_;
+       i = (i + 1) & mask_, ++n) {
+    page_id_t key = slots_[i].key.load(std::memory_order_relaxed);
+    if (key == page_id) {
+      slots_[i].value.store(page, std::memory_order_release);
+      return;
+    }
+    if (key == TOMBSTONE_PAGE_ID && target > mask_)
+      target = i;
+    if (key == INVALID_PAGE_ID) {
+      if (target > mask_)
+        target = i;
+      break;
+    }
+  }
+  assert(target <= mask_);
+  if (slots_[target].key.load(std::memory_order_relaxed) == TOMBSTONE_PAGE_ID)
+    num_tombstones_--;
+  slots_[target].value.store(page, std::memory_order_release);
+  slots_[target].key.store(page_id, std::memory_order_release);
+  num_entries_++;
+}
+
+/*
+ * Private helper: drop all tombstones by re-inserting the live entries.
+ * Concurrent readers may miss entries while this runs, which they tolerate
+ */
+void PageTable::Rebuild() {
+  std::vector<std::pair<page_id_t, Page *>> entries;
+  for (auto &slot : slots_) {
+    page_id_t key = slot.key.load(std::memory_order_relaxed);
+    if (key != INVALID_PAGE_ID && key != TOMBSTONE_PAGE_ID)
+      entries.emplace_back(key, slot.value.load(std::memory_order_relaxed));
+    slot.key.store(INVALID_PAGE_ID, std::memory_order_release);
+  }
+  num_entries_ = 0;
+  num_tombstones_ = 0;
+  for (auto &entry : entries) {
+    size_t i = HashKey(entry.first);
+    while (slots_[i].key.load(std::memory_order_relaxed) != INVALID_PAGE_ID)
+      i = (i + 1) & mask_;
+    slots_[i].value.store(entry.second, std::memory_order_release);
+    slots_[i].key.store(entry.first, std::memory_order_release);
+    num_entries_++;
+  }
+}
+
+} // namespace cmudb
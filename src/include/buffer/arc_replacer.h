@@ -0,0 +1,115 @@
+/**
+ * arc_replacer.h
+ *
+ * Functionality: Adaptive Replacement Cache (Megiddo & Modha). Resident frames
+ * live in T1 (seen once since they were loaded) or T2 (seen at least twice).
+ * Page ids of frames evicted from T1/T2 are remembered in the ghost lists
+ * B1/B2. Reloading a page found in B1 means T1 was too small and grows the
+ * target size p of T1, a page found in B2 shrinks it, so the cache drifts
+ * between recency (scans, OLTP bursts) and frequency (hot index pages) on its
+ * own. Ghost lists are bounded by the number of frames.
+ *
+ * The replacer only sees frames, so it asks page_id_of for the page id a frame
+ * currently holds when the frame is inserted. Values are mapped onto a flat
+ * array of frames by their distance from base, like ClockReplacer.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace cmudb {
+
+// snapshot of the adaptation state of an ARCReplacer
+struct ARCStatistics {
+  size_t target_t1_size = 0; // adaptation parameter p
+  size_t t1_size = 0;
+  size_t t2_size = 0;
+  size_t b1_size = 0;
+  size_t b2_size = 0;
+  uint64_t b1_ghost_hits = 0; // times p was increased
+  uint64_t b2_ghost_hits = 0; // times p was decreased
+};
+
+template <typename T> class ARCReplacer : public Replacer<T> {
+  enum ListType { LIST_NONE = 0, LIST_T1, LIST_T2 };
+  struct Frame {
+    T value;
+    page_id_t page_id = INVALID_PAGE_ID;
+    ListType list = LIST_NONE;
+    // position inside T1 or T2
+    std::list<size_t>::iterator position;
+    bool in_replacer = false;
+    // inserted by InsertPrefetched and not accessed since
+    bool prefetched = false;
+  };
+  // ghost list, most recent page id at the front
+  struct GhostList {
+    std::list<page_id_t> pages;
+    std::unordered_map<page_id_t, std::list<page_id_t>::iterator> index;
+  };
+
+public:
+  ARCReplacer(size_t num_frames,
+              std::function<page_id_t(const T &)> page_id_of, T base = T());
+
+  ~ARCReplacer();
+
+  void Insert(const T &value);
+
+  void InsertPrefetched(const T &value);
+
+  bool Victim(T &value);
+
+  std::vector<T> GetEvictionOrder();
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  ARCStatistics GetStatistics();
+
+  // change the cache size c that p and the ghost lists are bounded by, at
+  // most num_frames
+  void SetCapacity(size_t capacity);
+
+private:
+  inline size_t FrameSlot(const T &value) const { return value - base_; }
+
+  bool EvictFrom(std::list<size_t> &list, GhostList &ghost, T &value);
+
+  void Unlink(Frame &frame);
+
+  void AddGhost(GhostList &ghost, page_id_t page_id);
+
+  bool RemoveGhost(GhostList &ghost, page_id_t page_id);
+
+  void TrimGhosts();
+
+  size_t capacity_;
+  std::function<page_id_t(const T &)> page_id_of_;
+  T base_;
+  std::vector<Frame> frames_;
+  // resident frames, most recent at the front
+  std::list<size_t> t1_;
+  std::list<size_t> t2_;
+  GhostList b1_;
+  GhostList b2_;
+  // target size of T1
+  size_t p_;
+  // number of frames that can be evicted
+  size_t size_;
+  uint64_t b1_ghost_hits_;
+  uint64_t b2_ghost_hits_;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
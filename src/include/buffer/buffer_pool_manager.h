@@ -4,49 +4,359 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool can be split into several independent instances (partitions). A
+ * page id always maps onto the same instance (page_id % num_instances), and
+ * every instance owns a slice of the frames together with its own page table,
+ * replacer, free list and latch, so threads touching different instances
+ * never contend with each other.
+ *
+ * Buffer hits do not take the instance latch at all: the page table can be
+ * searched lock-free and pin counts are atomic, see FetchPage. Misses read
+ * the page without holding the latch either, so misses of one instance
+ * overlap their I/O. Read-ahead and FlushAllPages keep many reads and writes
+ * in flight through the asynchronous calls of the DiskManager.
+ *
+ * The pool can be resized online up to a budget of max_pool_size frames. The
+ * frames of the whole budget are reserved as virtual memory up front and are
+ * only backed by memory once they are taken into use, so page table entries
+ * and replacers never have to be moved. Page data lives in a FrameArena, huge
+ * page backed if possible, apart from the Page metadata.
+ *
+ * With NUMA enabled, instance i is bound to node i % num_nodes (frames and
+ * metadata), and NewPage prefers page ids that map onto an instance of the
+ * calling thread's node, see numa_topology.h. A page id is still mapped to an
+ * instance by page_id % num_instances, so fetches never look up a directory.
+ *
+ * With DISK_IO_DIRECT the database file bypasses the kernel page cache, so
+ * a page is not held in memory twice. The frames are aligned for O_DIRECT.
+ *
+ * With DISK_IO_MMAP the pool is read-only and skips its frames altogether:
+ * FetchPage hands out a Page whose data points into the mapped file, so a
+ * fetch never copies or evicts anything and the kernel page cache is the
+ * only cache. Writing to the data of such a page faults. FetchPageWrite and
+ * NewPage fail, and PrefetchPages becomes a madvise hint, see AdvisePages.
+ *
+ * Optionally, clean pages evicted from the frames move to a compressed page
+ * cache, where a later miss finds them before going to disk, see
+ * compressed_page_cache.h and SetCompressedCacheCapacity.
+ *
+ * The set of cached pages can survive a restart through a warm-up file: it
+ * lists the resident page ids, the ones most worth keeping first, and is
+ * loaded back into the free frames in page id order with large sequential
+ * reads before the pool serves requests, see SetWarmUpFile.
  */
 
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/numa_topology.h"
+#include "buffer/page_guard.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
+#include "hash/page_table.h"
 #include "page/page.h"
 
 namespace cmudb {
+class BufferRing;
+
 class BufferPoolManager {
+  friend class BufferRing;
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
 public:
-  BufferPoolManager(size_t pool_size, const std::string &db_file);
+  BufferPoolManager(size_t pool_size, const std::string &db_file,
+                    size_t num_instances = 1,
+                    ReplacerType replacer_type = REPLACER_TYPE_LRU,
+                    size_t max_pool_size = 0,
+                    NumaMode numa_mode = NUMA_MODE_OFF,
+                    DiskIOMode io_mode = DISK_IO_BUFFERED,
+                    DiskCompression compression = DISK_COMPRESSION_NONE);
 
   ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  // with a ring, a miss is read into one of the ring's frames instead of a
+  // victim of the shared replacer, see buffer_ring.h. A miss throws
+  // PageCorruptionException if the page fails its checksum
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr);
 
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
+  // FetchPage that also latches the page, the guard unlatches and unpins it
+  // when it goes out of scope, see page_guard.h
+  ReadPageGuard FetchPageRead(page_id_t page_id, BufferRing *ring = nullptr);
+
+  WritePageGuard FetchPageWrite(page_id_t page_id, BufferRing *ring = nullptr);
+
+  // NewPage returned write latched, the guard unpins it dirty
+  WritePageGuard NewPageWrite(page_id_t &page_id,
+                              page_id_t near = INVALID_PAGE_ID);
+
   bool FlushPage(page_id_t page_id);
 
   void FlushAllPages();
 
-  Page *NewPage(page_id_t &page_id);
+  // near, if given, is a page the new one is read together with, the disk
+  // manager places the new page in its extent if it can
+  Page *NewPage(page_id_t &page_id, page_id_t near = INVALID_PAGE_ID);
 
   bool DeletePage(page_id_t page_id);
 
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  inline size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  inline ArenaPageType GetArenaPageType() const {
+    return frame_arena_.GetPageType();
+  }
+
+  // DISK_IO_DIRECT if the pages are cached by the pool only, DISK_IO_MMAP if
+  // by the kernel only
+  inline DiskIOMode GetIOMode() const { return disk_manager_.GetIOMode(); }
+
+  // hint how pages [first_page_id, first_page_id + num_pages) are going to
+  // be fetched, passed on to the kernel with DISK_IO_MMAP, a no-op otherwise
+  void AdvisePages(page_id_t first_page_id, size_t num_pages,
+                   DiskAdvice advice);
+
+  // grow or shrink the pool to pool_size frames, between num_instances and
+  // max_pool_size. Shrinking writes back and drops the pages of the frames
+  // that go away, it fails for an instance where one of them is pinned, the
+  // other instances are resized anyway. return false if the pool does not
+  // have pool_size frames afterwards
+  bool ResizePool(size_t pool_size);
+
+  inline size_t GetNumInstances() const { return num_instances_; }
+
+  inline ReplacerType GetReplacerType() const { return replacer_type_; }
+
+  inline const NumaTopology &GetNumaTopology() const { return numa_; }
+
+  // node the frames of the instance of page_id are placed on
+  inline size_t GetNode(page_id_t page_id) {
+    return GetInstance(page_id).node_;
+  }
+
+  // adaptation state of the ARC replacers summed over all instances, all
+  // zero unless built with REPLACER_TYPE_ARC
+  ARCStatistics GetARCStatistics();
+
+  // hits, misses, evictions etc. since construction or the last reset, see
+  // buffer_pool_stats.h
+  BufferPoolStatistics GetStatistics();
+
+  // zero the counters, those of the compressed page cache too, and forget
+  // the page access counts
+  void ResetStatistics();
+
+  // count the fetches of every page id, off by default
+  void SetPageHeatTracking(bool enabled);
+
+  inline bool IsPageHeatTracking() const { return track_page_heat_; }
+
+  // (page id, fetches) of the hottest limit pages, all for 0, hottest first
+  std::vector<std::pair<page_id_t, uint64_t>> GetPageHeat(size_t limit = 0);
+
+  // bytes of memory for compressed copies of evicted clean pages, 0 (the
+  // default) turns the compressed page cache off and empties it
+  void SetCompressedCacheCapacity(size_t capacity);
+
+  inline size_t GetCompressedCacheCapacity() const {
+    return compressed_cache_.GetCapacity();
+  }
+
+  // hits, misses and compression ratio of the compressed page cache
+  CompressedCacheStatistics GetCompressedCacheStatistics();
+
+  // start a background thread that writes dirty unpinned pages back in page
+  // id order whenever fewer than low_watermark (fraction of the pool) frames
+  // are clean and evictable, until high_watermark of them are. The thread
+  // wakes up every interval_ms, or as soon as a foreground eviction had to
+  // write a dirty victim itself. Stopped by the destructor at the latest
+  void StartBackgroundWriter(double low_watermark, double high_watermark,
+                             int interval_ms = 100);
+
+  void StopBackgroundWriter();
+
+  // hint that pages [first_page_id, first_page_id + num_pages) are going to
+  // be fetched soon. A background thread reads them into the pool without
+  // pinning them, pages already cached or not written to disk yet are
+  // skipped, and the hint is dropped while too many pages are queued
+  void PrefetchPages(page_id_t first_page_id, size_t num_pages);
+
+  // block until all queued prefetches have been handled
+  void WaitForPrefetches();
+
+  // the cached page ids, most worth keeping first: pinned pages, then the
+  // others in reverse eviction order. Pages of buffer rings are left out
+  std::vector<page_id_t> GetResidentPages();
+
+  // write GetResidentPages to file_name, one page id per line
+  bool SaveWarmUpFile(const std::string &file_name);
+
+  // read the pages listed in file_name into the free frames, as many as fit
+  // in the order listed, without evicting anything. The most worth keeping
+  // are the last to be evicted. return the number of pages loaded
+  size_t LoadWarmUpFile(const std::string &file_name);
+
+  // save a warm-up file every time FlushAllPages runs, also on destruction.
+  // An empty file name turns it off
+  void SetWarmUpFile(const std::string &file_name);
+
 private:
-  size_t pool_size_;
-  // array of pages
+  // one partition of the buffer pool, see file comment
+  struct BufferPoolInstance {
+    // slice of the frames owned by this instance, the first pool_size_ of
+    // its max_pool_size_ frames are in use
+    Page *pages_;
+    size_t pool_size_;
+    size_t max_pool_size_;
+    // frames constructed so far, frames dropped by a shrink stay constructed
+    size_t num_constructed_;
+    // to keep track of page id and its memory location, lock-free lookups
+    PageTable *page_table_;
+    // to collect unpinned pages for replacement
+    Replacer<Page *> *replacer_;
+    // to collect free pages for replacement
+    std::list<Page *> *free_list_;
+    // to serialize page table updates, evictions and the free list of this
+    // instance
+    std::mutex latch_;
+    // NUMA node of the frames, 0 without NUMA
+    size_t node_;
+    // pages being read into a claimed frame without the latch held, they are
+    // in no page table yet. io_cv_ is notified when one is done
+    std::unordered_set<page_id_t> reading_;
+    std::condition_variable io_cv_;
+  };
+
+  inline BufferPoolInstance &GetInstance(page_id_t page_id) {
+    return instances_[page_id % num_instances_];
+  }
+
+  Page *GetVictimPage(BufferPoolInstance &instance);
+
+  Page *FetchMappedPage(page_id_t page_id);
+
+  bool UnpinMappedPage(Page *page);
+
+  void WriteBack(page_id_t page_id, Page *page);
+
+  void ReadIn(page_id_t page_id, Page *page);
+
+  // wait until no read of page_id into instance is in flight
+  inline void WaitForRead(BufferPoolInstance &instance,
+                          std::unique_lock<std::mutex> &lock,
+                          page_id_t page_id) {
+    instance.io_cv_.wait(
+        lock, [&] { return instance.reading_.count(page_id) == 0; });
+  }
+
+  // count a FetchPage of page_id
+  inline void RecordAccess(page_id_t page_id, bool is_hit) {
+    counters_.Add(is_hit ? BPM_COUNTER_HITS : BPM_COUNTER_MISSES);
+    if (track_page_heat_.load(std::memory_order_relaxed))
+      page_heat_.Record(page_id);
+  }
+
+  // count an access to a page of instance
+  inline void RecordNodeAccess(const BufferPoolInstance &instance) {
+    if (numa_.GetMode() != NUMA_MODE_OFF &&
+        instance.node_ != numa_.GetCurrentNode())
+      counters_.Add(BPM_COUNTER_REMOTE_ACCESSES);
+  }
+
+  page_id_t AllocateLocalPageId(page_id_t near);
+
+  Page *GetRingVictimPage(BufferPoolInstance &instance, BufferRing *ring);
+
+  void ReleaseRingFrame(BufferPoolInstance &instance, Page *page);
+
+  void ReleaseBufferRing(BufferRing *ring);
+
+  // unpin a page a guard holds, without looking it up in the page table
+  void ReleasePage(Page *page, bool is_dirty);
+
+  bool UnpinFrame(BufferPoolInstance &instance, Page *page, bool is_dirty);
+
+  bool TryPinPage(BufferPoolInstance &instance, Page *page, page_id_t page_id);
+
+  Replacer<Page *> *CreateReplacer(BufferPoolInstance &instance);
+
+  void GrowInstance(BufferPoolInstance &instance, size_t pool_size);
+
+  bool ShrinkInstance(BufferPoolInstance &instance, size_t pool_size);
+
+  void BackgroundWriterLoop();
+
+  void WriteBackDirtyPages();
+
+  void PrefetchLoop();
+
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids);
+
+  Page *LoadWarmUpPage(page_id_t page_id, const char *data);
+
+  std::atomic<size_t> pool_size_;
+  size_t max_pool_size_;
+  size_t num_instances_;
+  ReplacerType replacer_type_;
+  NumaTopology numa_;
+  // page ids allocated for, but not yet used by, the instances of other
+  // nodes, see AllocateLocalPageId
+  std::deque<page_id_t> spare_page_ids_;
+  std::mutex spare_page_ids_mutex_;
+  // metadata of max_pool_size_ pages, constructed on first use
   Page *pages_;
+  // data of max_pool_size_ pages, frame i belongs to pages_[i]
+  FrameArena frame_arena_;
   DiskManager disk_manager_;
-  // to keep track of page id and its memory location
-  HashTable<page_id_t, Page *> *page_table_;
-  // to collect unpinned pages for replacement
-  Replacer<Page *> *replacer_;
-  // to collect free pages for replacement
-  std::list<Page *> *free_list_;
-  // to protect shared data structure, you may need it for synchronization
-  // between replacer and page table
-  std::mutex latch_;
+  // DISK_IO_MMAP: the Page of every page of the mapped file, created on
+  // first fetch and never evicted
+  std::atomic<Page *> *mapped_pages_ = nullptr;
+  // array of num_instances_ partitions
+  BufferPoolInstance *instances_;
+  // serializes ResizePool calls
+  std::mutex resize_mutex_;
+  // background writer, see StartBackgroundWriter
+  std::thread writer_thread_;
+  std::mutex writer_mutex_;
+  std::condition_variable writer_cv_;
+  bool writer_running_ = false;
+  bool writer_wakeup_ = false;
+  double low_watermark_ = 0;
+  double high_watermark_ = 0;
+  int writer_interval_ms_ = 0;
+  // read-ahead thread, started by the first PrefetchPages
+  std::thread prefetch_thread_;
+  std::mutex prefetch_mutex_;
+  std::condition_variable prefetch_cv_;
+  std::deque<page_id_t> prefetch_queue_;
+  bool prefetch_running_ = false;
+  bool prefetch_busy_ = false;
+  // see SetWarmUpFile
+  std::string warm_up_file_;
+  std::mutex warm_up_mutex_;
+  // second cache tier, see SetCompressedCacheCapacity
+  CompressedPageCache compressed_cache_;
+  // telemetry, see GetStatistics
+  StripedCounters counters_;
+  PageHeatMap page_heat_;
+  std::atomic<bool> track_page_heat_{false};
 };
 } // namespace cmudb
@@ -0,0 +1,108 @@
+/**
+ * buffer_pool_stats.h
+ *
+ * Telemetry of the buffer pool manager. The event counters are striped over
+ * the cores: every thread increments the stripe of the core it first ran on,
+ * each stripe sits on cache lines of its own, so counting is a relaxed atomic
+ * add that threads on different cores never contend on. A snapshot sums the
+ * stripes, it is not atomic across counters.
+ *
+ * Access counts per page id are kept apart and only when enabled, they take
+ * a latch (one of PAGE_HEAT_STRIPES) on every access.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+enum BufferPoolCounter {
+  BPM_COUNTER_HITS = 0,         // fetches of a page found in the pool
+  BPM_COUNTER_MISSES,           // fetches that read the page from disk
+  BPM_COUNTER_EVICTIONS,        // pages dropped to make room for another
+  BPM_COUNTER_DIRTY_WRITEBACKS, // dirty pages written to disk
+  BPM_COUNTER_PIN_WAITS,        // hits that could not pin the page lock-free
+                                // and waited for the instance latch
+  BPM_COUNTER_FREE_LIST_EMPTY,  // frames needed while the free list was empty
+  BPM_COUNTER_REMOTE_ACCESSES,  // fetched or new pages of an instance on
+                                // another NUMA node than the caller's
+  BPM_COUNTER_COUNT
+};
+
+// snapshot of the counters of a BufferPoolManager
+struct BufferPoolStatistics {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  uint64_t dirty_writebacks = 0;
+  uint64_t pin_waits = 0;
+  uint64_t free_list_empty = 0;
+  uint64_t remote_accesses = 0;
+};
+
+// name of counter, as reported by the bpm_stats virtual table
+const char *BufferPoolCounterName(BufferPoolCounter counter);
+
+// value of counter in stats
+uint64_t GetCounterValue(const BufferPoolStatistics &stats,
+                         BufferPoolCounter counter);
+
+class StripedCounters {
+  // padded to two cache lines, the counters of neighbouring stripes never
+  // share a line whatever the alignment of the array
+  struct Stripe {
+    std::atomic<uint64_t> values[BPM_COUNTER_COUNT];
+    char padding[128 - sizeof(std::atomic<uint64_t>) * BPM_COUNTER_COUNT];
+  };
+
+public:
+  // one stripe per hardware thread
+  StripedCounters();
+  ~StripedCounters();
+  StripedCounters(const StripedCounters &) = delete;
+  StripedCounters &operator=(const StripedCounters &) = delete;
+
+  inline void Add(BufferPoolCounter counter, uint64_t n = 1) {
+    stripes_[GetStripe()].values[counter].fetch_add(n,
+                                                    std::memory_order_relaxed);
+  }
+
+  BufferPoolStatistics Snapshot() const;
+
+  void Reset();
+
+private:
+  size_t GetStripe() const;
+
+  Stripe *stripes_;
+  size_t num_stripes_;
+};
+
+class PageHeatMap {
+  struct Stripe {
+    std::mutex latch;
+    std::unordered_map<page_id_t, uint64_t> counts;
+  };
+
+public:
+  void Record(page_id_t page_id);
+
+  // page ids with their access counts, hottest first (ties by page id),
+  // at most limit of them unless limit is 0
+  std::vector<std::pair<page_id_t, uint64_t>> Snapshot(size_t limit = 0);
+
+  void Reset();
+
+private:
+  Stripe stripes_[PAGE_HEAT_STRIPES];
+};
+
+} // namespace cmudb
@@ -0,0 +1,47 @@
+/**
+ * buffer_ring.h
+ *
+ * Buffer access strategy for large sequential scans. A ring owns a few frames
+ * of every buffer pool instance, and pages the scan misses on are read into
+ * the next frame of the ring, replacing the page the scan read there one lap
+ * before. The scan therefore occupies at most the frames of its ring, and
+ * those frames never enter the shared replacer, so neither the cached pages
+ * nor the access history of other queries are pushed out.
+ *
+ * A frame that is pinned by somebody else when its turn comes is handed back
+ * to the shared pool and replaced by a regular victim. The destructor hands
+ * back all frames. See BufferPoolManager::FetchPage.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+class BufferRing {
+  friend class BufferPoolManager;
+  // ring of one buffer pool instance, nullptr for slots not used yet
+  struct Slots {
+    std::vector<Page *> frames;
+    size_t next = 0;
+  };
+
+public:
+  // ring_size: frames of the whole ring, split across the instances. Each
+  // instance contributes at least 2 frames (the current and the next page of
+  // a scan) and at most a quarter of its frames
+  BufferRing(BufferPoolManager *buffer_pool_manager,
+             size_t ring_size = BUFFER_RING_SIZE);
+
+  ~BufferRing();
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  // indexed like the buffer pool instances
+  std::vector<Slots> slots_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,57 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) approximation of LRU. Every frame owns
+ * one slot of a flat array holding a reference bit, so Insert/Erase never
+ * touch a list or a hash table. Victim sweeps a clock hand over the slots,
+ * clearing reference bits until it finds an unreferenced frame.
+ *
+ * Values are mapped onto slots by their distance from base, which must be the
+ * first frame of the pool (e.g. the Page array, or 0 for frame numbers).
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+  struct Frame {
+    T value;
+    bool in_replacer = false;
+    bool reference = false;
+  };
+
+public:
+  ClockReplacer(size_t num_frames, T base = T());
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  void InsertPrefetched(const T &value);
+
+  bool Victim(T &value);
+  std::vector<T> GetEvictionOrder();
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+private:
+  inline size_t FrameSlot(const T &value) const { return value - base_; }
+
+  T base_;
+  std::vector<Frame> frames_;
+  // slot the clock hand points at
+  size_t hand_;
+  // number of frames currently in the replacer
+  size_t size_;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
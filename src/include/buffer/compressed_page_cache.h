@@ -0,0 +1,89 @@
+/**
+ * compressed_page_cache.h
+ *
+ * Second cache tier between the buffer pool and the disk. It keeps clean
+ * pages the buffer pool evicted in compressed form (see lz_codec.h), so the
+ * same memory holds several times as many pages as frames would. A buffer
+ * miss takes the page out of this cache before it reads the disk, a page is
+ * never cached by both tiers at once.
+ *
+ * Only pages that compress to COMPRESSED_CACHE_MAX_SIZE bytes or less are
+ * kept, and the least recently inserted ones are dropped to stay within the
+ * capacity. The capacity counts the compressed bytes, not the bookkeeping of
+ * roughly 100 bytes per page.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+struct CompressedCacheStatistics {
+  uint64_t hits = 0;      // pages found by Take
+  uint64_t misses = 0;    // pages Take did not find
+  uint64_t inserts = 0;   // pages stored
+  uint64_t rejects = 0;   // pages that did not compress well enough
+  uint64_t evictions = 0; // pages dropped for room
+  size_t num_pages = 0;   // pages currently held
+  size_t size = 0;        // their compressed bytes
+
+  // uncompressed over compressed size of the pages held, 0 if empty
+  inline double GetCompressionRatio() const {
+    return size == 0 ? 0 : static_cast<double>(num_pages) * PAGE_SIZE / size;
+  }
+};
+
+class CompressedPageCache {
+public:
+  // capacity: bytes of compressed pages held at most, 0 disables the cache
+  explicit CompressedPageCache(size_t capacity = 0);
+
+  // shrinking drops the least recently inserted pages, 0 empties the cache
+  void SetCapacity(size_t capacity);
+
+  inline size_t GetCapacity() const { return capacity_; }
+
+  // keep a copy of PAGE_SIZE bytes of data as the content of page_id,
+  // replacing the one kept before. The data must match the disk
+  void Insert(page_id_t page_id, const char *data);
+
+  // copy the content of page_id to data and drop it from the cache
+  // return false if the cache does not hold page_id
+  bool Take(page_id_t page_id, char *data);
+
+  // forget page_id, e.g. when it is deleted
+  void Erase(page_id_t page_id);
+
+  CompressedCacheStatistics GetStatistics();
+
+  void ResetStatistics();
+
+private:
+  struct Entry {
+    std::string data;
+    // position in lru_
+    std::list<page_id_t>::iterator position;
+  };
+
+  void Shrink(size_t capacity);
+
+  void Remove(std::unordered_map<page_id_t, Entry>::iterator it);
+
+  std::atomic<size_t> capacity_;
+  std::mutex latch_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  // most recently inserted first
+  std::list<page_id_t> lru_;
+  size_t size_ = 0;
+  CompressedCacheStatistics stats_;
+};
+
+} // namespace cmudb
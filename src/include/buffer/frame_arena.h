@@ -0,0 +1,70 @@
+/**
+ * frame_arena.h
+ *
+ * Memory for the page data of the buffer pool frames: one anonymous mapping
+ * holding num_frames frames of PAGE_SIZE bytes each, every frame 4KB aligned
+ * so it can be handed to O_DIRECT reads and writes as is. A large pool
+ * touches a lot of memory at random, so the arena tries to back it with huge
+ * pages to cut down on TLB misses: hugetlbfs pages first (1GB pages for
+ * arenas of 1GB and more, 2MB pages otherwise), then transparent huge pages,
+ * and plain pages if neither is available. The page metadata lives elsewhere,
+ * see BufferPoolManager.
+ *
+ * The memory is reserved but only backed once it is touched, and Release
+ * hands it back to the kernel, e.g. when the pool shrinks.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+// what backs the memory of a FrameArena
+enum ArenaPageType {
+  ARENA_PAGE_REGULAR = 0,
+  ARENA_PAGE_TRANSPARENT_HUGE = 1, // madvise(MADV_HUGEPAGE)
+  ARENA_PAGE_HUGETLB_2MB = 2,
+  ARENA_PAGE_HUGETLB_1GB = 3,
+};
+
+class FrameArena {
+public:
+  // use_huge_pages: false to always use regular pages, e.g. for comparison
+  FrameArena(size_t num_frames, bool use_huge_pages = true);
+
+  ~FrameArena();
+
+  inline char *GetFrame(size_t frame_id) const {
+    return base_ + frame_id * PAGE_SIZE;
+  }
+
+  inline size_t GetNumFrames() const { return num_frames_; }
+
+  inline ArenaPageType GetPageType() const { return page_type_; }
+
+  // granularity of the mapping, e.g. 2MB for ARENA_PAGE_HUGETLB_2MB
+  inline size_t GetMappingPageSize() const { return page_size_; }
+
+  // give the memory of frames [first_frame_id, first_frame_id + num_frames)
+  // back to the kernel, as far as it covers whole pages of the arena. The
+  // frames read as zeros afterwards
+  void Release(size_t first_frame_id, size_t num_frames);
+
+private:
+  bool MapHugeTLB(size_t huge_page_size, int size_flag);
+
+  void MapAligned(size_t alignment);
+
+  char *base_;
+  size_t num_frames_;
+  // size of the mapping, a multiple of page_size_
+  size_t mapped_size_;
+  // granularity of the mapping
+  size_t page_size_;
+  ArenaPageType page_type_;
+};
+
+} // namespace cmudb
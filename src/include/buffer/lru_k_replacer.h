@@ -0,0 +1,75 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement. Every Insert counts as one access of the
+ * frame and the replacer remembers the timestamps of the last K accesses.
+ * Victim evicts the frame whose K-th most recent access lies furthest in the
+ * past (largest backward K-distance). Frames seen fewer than K times have an
+ * infinite distance and go first, oldest first access first, so pages touched
+ * once by a sequential scan cannot push out pages that are used repeatedly.
+ *
+ * The access history survives Erase (the page is pinned, not gone) and is
+ * dropped when the frame is chosen as victim. Like ClockReplacer, values are
+ * mapped onto a flat array of frames by their distance from base.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+  struct Frame {
+    T value;
+    bool in_replacer = false;
+    // inserted by InsertPrefetched and not accessed since
+    bool prefetched = false;
+    // timestamps of the last (at most) K accesses, oldest at the front
+    std::deque<uint64_t> history;
+  };
+  // (has K accesses, timestamp that decides eviction, frame slot)
+  typedef std::tuple<bool, uint64_t, size_t> EvictionKey;
+
+public:
+  LRUKReplacer(size_t num_frames, size_t k = 2, T base = T());
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value);
+
+  void InsertPrefetched(const T &value);
+
+  bool Victim(T &value);
+
+  std::vector<T> GetEvictionOrder();
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  inline size_t GetK() const { return k_; }
+
+private:
+  inline size_t FrameSlot(const T &value) const { return value - base_; }
+
+  EvictionKey GetEvictionKey(size_t slot) const;
+
+  size_t k_;
+  T base_;
+  std::vector<Frame> frames_;
+  // evictable frames ordered by eviction priority
+  std::set<EvictionKey> evictable_;
+  // logical clock, advanced on every access
+  uint64_t current_timestamp_;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
@@ -9,6 +9,10 @@
 
 #pragma once
 
+#include <list>
+#include <mutex>
+#include <vector>
+
 #include "buffer/replacer.h"
 #include "hash/extendible_hash.h"
 
@@ -25,12 +29,18 @@ public:
 
   bool Victim(T &value);
 
+  std::vector<T> GetEvictionOrder();
+
   bool Erase(const T &value);
 
   size_t Size();
 
 private:
-  // add your member variables here
+  // most recently used value at the front, victim taken from the back
+  std::list<T> lru_list_;
+  // to locate a value inside lru_list_ without a linear scan
+  ExtendibleHash<T, typename std::list<T>::iterator> index_;
+  std::mutex latch_;
 };
 
 } // namespace cmudb
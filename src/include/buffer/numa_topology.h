@@ -0,0 +1,60 @@
+/**
+ * numa_topology.h
+ *
+ * The NUMA nodes the buffer pool places its instances on, and the node a
+ * thread runs on. The nodes and their cpus are read from sysfs, memory is
+ * bound to a node with the mbind system call, so no libnuma is needed.
+ *
+ * Emulation splits the cpus of the machine round-robin into
+ * NUMA_EMULATED_NODES nodes and binds nothing, so the placement logic can be
+ * exercised and measured on a single-node machine.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+enum NumaMode {
+  NUMA_MODE_OFF = 0,     // one node, memory wherever the kernel puts it
+  NUMA_MODE_BIND = 1,    // the nodes of the machine, memory bound to them
+  NUMA_MODE_EMULATE = 2, // NUMA_EMULATED_NODES nodes, nothing bound
+};
+
+class NumaTopology {
+public:
+  explicit NumaTopology(NumaMode mode);
+
+  inline NumaMode GetMode() const { return mode_; }
+
+  inline size_t GetNumNodes() const { return num_nodes_; }
+
+  // node of the cpu the calling thread runs on, unless overridden with
+  // SetThreadNode
+  size_t GetCurrentNode() const;
+
+  // bind the memory pages within [address, address + size) to node, pages
+  // already touched are moved. page_size is the granularity of the mapping,
+  // 0 for regular pages. Best effort, return false if nothing was bound (not
+  // in NUMA_MODE_BIND, or the kernel refused)
+  bool BindMemory(void *address, size_t size, size_t node,
+                  size_t page_size = 0) const;
+
+  // let the calling thread count as running on node, in any topology, e.g.
+  // for threads of an emulated node. -1 goes back to the cpu's node
+  static void SetThreadNode(int node);
+
+private:
+  void ReadSystemNodes();
+
+  NumaMode mode_;
+  size_t num_nodes_;
+  // node of every cpu, empty if cpus map round-robin onto the nodes
+  std::vector<size_t> cpu_node_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,116 @@
+/**
+ * page_guard.h
+ *
+ * Scoped access to a page of the buffer pool. A guard holds the pin and the
+ * latch of one page and gives both back when it goes out of scope, so a page
+ * can no longer be leaked pinned by an early return. Guards are move-only and
+ * live on the stack, releasing one unpins the frame directly without a page
+ * table lookup.
+ *
+ * Obtained from BufferPoolManager::FetchPageRead, FetchPageWrite and
+ * NewPageWrite. A guard for a page that could not be fetched (all frames
+ * pinned) is invalid, test it with IsValid before use.
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace cmudb {
+class BufferPoolManager;
+
+// shared latch, the page is unpinned clean
+class ReadPageGuard {
+public:
+  ReadPageGuard() = default;
+  // page must be pinned and read latched by the caller
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+  ReadPageGuard(ReadPageGuard &&that) noexcept
+      : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_) {
+    that.page_ = nullptr;
+  }
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept {
+    if (this != &that) {
+      Release();
+      buffer_pool_manager_ = that.buffer_pool_manager_;
+      page_ = that.page_;
+      that.page_ = nullptr;
+    }
+    return *this;
+  }
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+  ~ReadPageGuard() { Release(); }
+
+  // unlatch and unpin the page early, the guard becomes invalid
+  void Release();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+  inline Page *GetPage() const { return page_; }
+  inline const char *GetData() const { return page_->GetData(); }
+  // view of the page content, e.g. As<BPlusTreePage>()
+  template <typename T> inline const T *As() const {
+    return reinterpret_cast<const T *>(page_->GetData());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+};
+
+// exclusive latch, the page is unpinned dirty once it has been modified
+// through AsMut or GetDataMut, or marked with SetDirty
+class WritePageGuard {
+public:
+  WritePageGuard() = default;
+  // page must be pinned and write latched by the caller
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page,
+                 bool is_dirty = false)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page),
+        is_dirty_(is_dirty) {}
+  WritePageGuard(WritePageGuard &&that) noexcept
+      : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_),
+        is_dirty_(that.is_dirty_) {
+    that.page_ = nullptr;
+  }
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept {
+    if (this != &that) {
+      Release();
+      buffer_pool_manager_ = that.buffer_pool_manager_;
+      page_ = that.page_;
+      is_dirty_ = that.is_dirty_;
+      that.page_ = nullptr;
+    }
+    return *this;
+  }
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+  ~WritePageGuard() { Release(); }
+
+  // unlatch and unpin the page early, the guard becomes invalid
+  void Release();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+  inline Page *GetPage() const { return page_; }
+  inline void SetDirty() { is_dirty_ = true; }
+  inline const char *GetData() const { return page_->GetData(); }
+  inline char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+  template <typename T> inline const T *As() const {
+    return reinterpret_cast<const T *>(page_->GetData());
+  }
+  template <typename T> inline T *AsMut() {
+    is_dirty_ = true;
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+} // namespace cmudb
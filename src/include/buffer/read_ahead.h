@@ -0,0 +1,37 @@
+/**
+ * read_ahead.h
+ *
+ * Sequential access detection for scans. The scan reports every page it moves
+ * to, and once it moves from a page to the one right after it on disk, the
+ * following window pages are handed to BufferPoolManager::PrefetchPages. The
+ * window is topped up when half of it has been consumed, so the pages are
+ * read in batches ahead of the scan instead of one at a time on demand.
+ *
+ * With a mapped file (DISK_IO_MMAP) the window is also advised sequential,
+ * so the kernel reads it ahead in large chunks and drops it behind the scan.
+ */
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+class ReadAhead {
+public:
+  // window: number of pages to read ahead, 0 disables read-ahead. Capped at
+  // a quarter of the pool so that read-ahead cannot flush it, unless the
+  // pool is a mapped file
+  ReadAhead(BufferPoolManager *buffer_pool_manager, size_t window);
+
+  void OnPageAccess(page_id_t page_id);
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  size_t window_;
+  page_id_t last_page_id_;
+  // pages before this one have been requested already
+  page_id_t prefetched_until_;
+};
+
+} // namespace cmudb
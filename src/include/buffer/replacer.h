@@ -6,15 +6,30 @@
 #pragma once
 
 #include <cstdlib>
+#include <vector>
 
 namespace cmudb {
 
+// replacement policies the buffer pool manager can be built with
+enum ReplacerType {
+  REPLACER_TYPE_LRU = 0,   // exact LRU, see lru_replacer.h
+  REPLACER_TYPE_CLOCK = 1, // second chance, see clock_replacer.h
+  REPLACER_TYPE_LRU_K = 2, // LRU-2, scan resistant, see lru_k_replacer.h
+  REPLACER_TYPE_ARC = 3,   // adaptive, see arc_replacer.h
+};
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
   virtual ~Replacer() {}
   virtual void Insert(const T &value) = 0;
+  // make value evictable without counting it as an access, e.g. a frame that
+  // was read ahead and not used yet. The next Insert is its first access
+  virtual void InsertPrefetched(const T &value) { Insert(value); }
   virtual bool Victim(T &value) = 0;
+  // the evictable values in the order Victim would return them if nothing
+  // else happened in between, the replacer is not changed
+  virtual std::vector<T> GetEvictionOrder() = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
 };
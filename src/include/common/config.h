@@ -12,7 +12,24 @@ namespace cmudb {
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define HEADER_PAGE_ID 0   // the header page id
 #define PAGE_SIZE 4096     // size of a data page in byte
+#define PAGE_CHECKSUM_SIZE 4 // CRC32C at the end of every page on disk
+// bytes of a page the page layouts may use, the checksum takes the rest
+#define PAGE_DATA_SIZE (PAGE_SIZE - PAGE_CHECKSUM_SIZE)
 #define BUCKET_SIZE 50     // size of extendible hash bucket
+#define READ_AHEAD_PAGES 8 // default read-ahead window of sequential scans
+#define BUFFER_RING_SIZE 16 // default number of frames of a scan buffer ring
+#define PAGE_HEAT_STRIPES 64 // latches of the per page access counters
+#define WARM_UP_READ_PAGES 64 // largest read while loading a warm-up file
+#define NUMA_EMULATED_NODES 2 // nodes of NUMA_MODE_EMULATE
+#define NUMA_SPARE_PAGE_IDS 64 // page ids NewPage holds back for other nodes
+#define ASYNC_IO_QUEUE_DEPTH 64 // I/Os an io_uring engine keeps in flight
+#define ASYNC_IO_THREADS 8      // threads of the fallback engine
+#define DIRECT_IO_ALIGNMENT 4096 // buffer alignment O_DIRECT asks for at most
+#define FSM_PAGE_BITS (PAGE_SIZE * 8) // pages tracked by a free space map page
+#define EXTENT_PAGES 64 // pages the database file is preallocated by at once
+#define COMPRESSED_SLOT_SIZE 512 // unit compressed pages are stored in
+// largest compressed page kept by the compressed page cache
+#define COMPRESSED_CACHE_MAX_SIZE (PAGE_SIZE * 3 / 4)
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
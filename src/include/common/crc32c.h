@@ -0,0 +1,32 @@
+/**
+ * crc32c.h
+ *
+ * CRC-32C (Castagnoli polynomial 0x1EDC6F41, bit reflected), the checksum
+ * of iSCSI, ext4 and SSE4.2's crc32 instruction. On x86-64 processors with
+ * SSE4.2 the instruction does the work, over three independent streams at
+ * once to hide its latency. Elsewhere a slicing-by-8 table implementation
+ * takes its place, it handles 8 bytes per step with 8 table lookups.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cmudb {
+
+class CRC32C {
+public:
+  // checksum of size bytes at data. crc is the checksum of the bytes before,
+  // so a buffer can be checksummed in pieces
+  static uint32_t Checksum(const char *data, size_t size, uint32_t crc = 0);
+
+  // Checksum with the table implementation, whatever the processor supports
+  static uint32_t ChecksumPortable(const char *data, size_t size,
+                                   uint32_t crc = 0);
+
+  // whether Checksum uses the crc32 instruction
+  static bool IsHardwareAccelerated();
+};
+
+} // namespace cmudb
@@ -41,6 +41,7 @@ enum ExceptionType {
   EXCEPTION_TYPE_STAT = 20,             // stat related
   EXCEPTION_TYPE_CONNECTION = 21,       // connection related
   EXCEPTION_TYPE_SYNTAX = 22,           // syntax related
+  EXCEPTION_TYPE_CORRUPTION = 23,       // data read back damaged
 };
 
 class Exception : public std::runtime_error {
@@ -107,6 +108,8 @@ public:
       return "Connection";
     case EXCEPTION_TYPE_SYNTAX:
       return "Syntax";
+    case EXCEPTION_TYPE_CORRUPTION:
+      return "Corruption";
     default:
       return "Unknown";
     }
@@ -341,4 +344,19 @@ public:
       : Exception(EXCEPTION_TYPE_CONNECTION, msg) {}
 };
 
+class PageCorruptionException : public Exception {
+  PageCorruptionException() = delete;
+
+public:
+  PageCorruptionException(int page_id, std::string msg)
+      : Exception(EXCEPTION_TYPE_CORRUPTION,
+                  "page " + std::to_string(page_id) + " " + msg),
+        page_id_(page_id) {}
+
+  inline int GetPageId() const { return page_id_; }
+
+private:
+  int page_id_;
+};
+
 } // namespace cmudb
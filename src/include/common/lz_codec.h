@@ -0,0 +1,37 @@
+/**
+ * lz_codec.h
+ *
+ * A small LZ77 codec in the LZ4 block format: a token byte holds the
+ * literal length and the match length (minus 4) in 4 bits each, 15 meaning
+ * more length bytes follow (255 meaning more again), then the literals, a
+ * 2 byte little-endian match offset and the extra match length bytes. The
+ * last sequence has literals only. The compressor is a greedy single pass
+ * over a hash table of 4 byte prefixes, fast rather than tight, which suits
+ * page images full of zeros and repeated tuple layouts.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace cmudb {
+
+class LZCodec {
+public:
+  // largest output of Compress for size input bytes
+  static inline size_t MaxCompressedSize(size_t size) {
+    return size + size / 255 + 16;
+  }
+
+  // compress size bytes of src into dst, which holds capacity bytes
+  // return the compressed size, 0 if it does not fit into capacity
+  static size_t Compress(const char *src, size_t size, char *dst,
+                         size_t capacity);
+
+  // decompress size bytes of src into exactly dst_size bytes at dst
+  // return false if src is malformed or does not expand to dst_size bytes
+  static bool Decompress(const char *src, size_t size, char *dst,
+                         size_t dst_size);
+};
+
+} // namespace cmudb
@@ -0,0 +1,129 @@
+/**
+ * async_io.h
+ *
+ * Engines that run positional reads and writes in the background, so that a
+ * caller can keep many of them in flight. The io_uring engine talks to the
+ * kernel through the raw system calls (no liburing needed) and reaps the
+ * completions with a thread of its own. Where io_uring is not available
+ * (old kernels, seccomp filters) a pool of threads doing preadv/pwritev
+ * takes its place.
+ *
+ * Callbacks run on an engine thread, one after the other for io_uring, so
+ * they must be short and must never wait for other I/O of the same engine.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace cmudb {
+
+enum AsyncIOBackend {
+  ASYNC_IO_AUTO = 0,        // io_uring if available, else the thread pool
+  ASYNC_IO_URING = 1,       // io_uring
+  ASYNC_IO_THREAD_POOL = 2, // ASYNC_IO_THREADS threads doing blocking I/O
+};
+
+enum AsyncIOOp { ASYNC_IO_READ = 0, ASYNC_IO_WRITE };
+
+struct AsyncIORequest {
+  AsyncIOOp op;
+  int fd;
+  off_t offset;
+  // buffers to transfer, in order, at offset
+  std::vector<struct iovec> iov;
+  // called once with the bytes transferred, or -errno
+  std::function<void(ssize_t)> callback;
+};
+
+class AsyncIOEngine {
+public:
+  virtual ~AsyncIOEngine() {}
+
+  // take over request and run it, may block while the engine is full
+  virtual void Submit(AsyncIORequest *request) = 0;
+
+  virtual AsyncIOBackend GetBackend() const = 0;
+
+  // an engine of backend, ASYNC_IO_AUTO and ASYNC_IO_URING fall back to the
+  // thread pool if io_uring cannot be set up
+  static AsyncIOEngine *Create(AsyncIOBackend backend);
+};
+
+class IOUringEngine : public AsyncIOEngine {
+public:
+  IOUringEngine();
+  // waits for the requests in flight
+  ~IOUringEngine();
+
+  // set up a ring of num_entries submission entries
+  // return false if the kernel does not support io_uring
+  bool Init(unsigned num_entries);
+
+  void Submit(AsyncIORequest *request) override;
+
+  AsyncIOBackend GetBackend() const override { return ASYNC_IO_URING; }
+
+private:
+  void PushEntry(AsyncIORequest *request);
+
+  void CompletionLoop();
+
+  int ring_fd_;
+  unsigned num_entries_;
+  // the rings shared with the kernel
+  char *sq_ring_;
+  size_t sq_ring_size_;
+  char *cq_ring_;
+  size_t cq_ring_size_;
+  struct io_uring_sqe *sqes_;
+  size_t sqes_size_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  struct io_uring_cqe *cqes_;
+  // serializes submissions and counts the requests in flight, at most
+  // num_entries_ so the completion ring never overflows
+  std::mutex latch_;
+  std::condition_variable slot_cv_;
+  unsigned num_in_flight_ = 0;
+  bool stopping_ = false;
+  std::thread completion_thread_;
+};
+
+class ThreadPoolEngine : public AsyncIOEngine {
+public:
+  explicit ThreadPoolEngine(size_t num_threads);
+  // runs the requests queued so far
+  ~ThreadPoolEngine();
+
+  void Submit(AsyncIORequest *request) override;
+
+  AsyncIOBackend GetBackend() const override { return ASYNC_IO_THREAD_POOL; }
+
+private:
+  void WorkerLoop();
+
+  std::mutex latch_;
+  std::condition_variable queue_cv_;
+  std::deque<AsyncIORequest *> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace cmudb
@@ -5,33 +5,302 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Every page carries a CRC32C of its first PAGE_DATA_SIZE bytes in its last
+ * PAGE_CHECKSUM_SIZE bytes. The writes stamp it on a copy of the page, so the
+ * checksum matches what is written even while the caller's buffer changes,
+ * and the reads verify it and throw PageCorruptionException on a mismatch.
+ * A page of zeros, never written or a hole, passes.
+ *
+ * With DISK_IO_DIRECT the file is opened with O_DIRECT, so pages cached by
+ * the buffer pool are not cached a second time by the kernel. Buffers that
+ * are not aligned to DIRECT_IO_ALIGNMENT (buffer pool frames are) are copied
+ * through an aligned one.
+ *
+ * With DISK_IO_MMAP the file is opened read-only and mapped into memory as a
+ * whole, for replicas that only read: GetMappedPage points straight into the
+ * kernel page cache, and AdvisePages passes access hints on with madvise.
+ * The file is mapped at the size it has when opened, writes and allocations
+ * throw, and the free space map is neither read nor written.
+ *
+ * Which pages are allocated is tracked by a bitmap, cached in memory and
+ * kept in the free space map file <db file>.fsm next to the database: a
+ * header page with the end of the allocated pages, then one page of bits per
+ * FSM_PAGE_BITS pages. Deallocated pages are handed out again before the
+ * file grows. The map is written by Sync and on destruction, and only once a
+ * page has been deallocated, a file without holes needs no map.
+ *
+ * The pages are grouped into extents of EXTENT_PAGES pages, and the file is
+ * preallocated with fallocate one whole extent at a time. An allocation near
+ * a hint page stays within the hint's extent, or starts a new extent of its
+ * own, so that a chain of pages allocated each near the previous one is laid
+ * out contiguously even while other chains grow.
+ *
+ * On open, the allocation state is rebuilt from the map and the file size,
+ * reading the map pages only: pages past the end recorded by the map but
+ * within the file were allocated since the map was written.
+ *
+ * With DISK_COMPRESSION_LZ every page is compressed with LZCodec when it is
+ * written, checksum included, and stored in as few slots of
+ * COMPRESSED_SLOT_SIZE bytes as it fits into: a 2 byte size and the
+ * compressed bytes, or the page as is if that saves no slot. The location
+ * map file <db file>.loc next to the database holds the first slot and the
+ * number of slots of every page, after a header page. A page that needs
+ * the same number of slots again is rewritten in place, else it moves to
+ * other slots. The slots it leaves are only reused once the map no longer
+ * points to them on disk, after the next Sync, which punches them out of
+ * the file as well. So a crash leaves the pages as they were at the last
+ * Sync, or as last written in place. A deallocated page gives its slots up
+ * and reads as zeros. Pages are read decompressed, the buffer pool
+ * decompresses once per miss.
  */
 
 #pragma once
 #include <atomic>
-#include <fstream>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "disk/async_io.h"
 
 namespace cmudb {
 
+enum DiskIOMode {
+  DISK_IO_BUFFERED = 0, // through the kernel page cache
+  DISK_IO_DIRECT = 1,   // O_DIRECT, bypassing the kernel page cache
+  DISK_IO_MMAP = 2,     // mapped read-only, see file comment
+};
+
+enum DiskCompression {
+  DISK_COMPRESSION_NONE = 0, // page page_id at page_id * PAGE_SIZE
+  DISK_COMPRESSION_LZ = 1,   // in slots, see file comment
+};
+
+enum DiskAdvice {
+  DISK_ADVICE_NORMAL = 0,     // no particular order
+  DISK_ADVICE_SEQUENTIAL = 1, // in ascending order, read far ahead
+  DISK_ADVICE_RANDOM = 2,     // in no order, do not read ahead
+  DISK_ADVICE_WILLNEED = 3,   // soon, start reading now
+};
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  // open or create db_file, throw if that fails or the file does not
+  // consist of whole pages. backend serves the asynchronous calls.
+  // DISK_IO_DIRECT falls back to DISK_IO_BUFFERED if the file system does
+  // not support O_DIRECT. DISK_IO_MMAP throws if the file does not exist.
+  // compression must be the one the file was written with, it cannot be
+  // combined with DISK_IO_MMAP
+  DiskManager(const std::string &db_file,
+              AsyncIOBackend backend = ASYNC_IO_AUTO,
+              DiskIOMode io_mode = DISK_IO_BUFFERED,
+              DiskCompression compression = DISK_COMPRESSION_NONE);
   ~DiskManager();
 
+  // the last PAGE_CHECKSUM_SIZE bytes of page_data are not written, the
+  // checksum takes their place
   void WritePage(page_id_t page_id, const char *page_data);
+  // throw PageCorruptionException if the page read fails its checksum, or
+  // fails to decompress
   void ReadPage(page_id_t page_id, char *page_data);
+  // read num_pages consecutive pages with one request
+  void ReadPages(page_id_t first_page_id, size_t num_pages, char *data);
+  // write num_pages consecutive pages, the i-th from pages[i], with few
+  // large requests and without syncing
+  void WritePages(page_id_t first_page_id, const char *const *pages,
+                  size_t num_pages);
+  // make every write so far durable
+  void Sync();
 
-  page_id_t AllocatePage();
+  // asynchronous versions of the above, they return once the request is
+  // queued and call callback with whether it succeeded from an I/O thread,
+  // a read fails its checksum with false.
+  // The buffers must stay valid until then, a callback must not wait for
+  // other asynchronous I/O
+  void ReadPageAsync(page_id_t page_id, char *page_data,
+                     std::function<void(bool)> callback);
+  void WritePageAsync(page_id_t page_id, const char *page_data,
+                      std::function<void(bool)> callback);
+  void WritePagesAsync(page_id_t first_page_id, const char *const *pages,
+                       size_t num_pages, std::function<void(bool)> callback);
+  // the same, the future tells whether the request succeeded
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+  std::future<bool> WritePageAsync(page_id_t page_id, const char *page_data);
+  std::future<bool> WritePagesAsync(page_id_t first_page_id,
+                                    const char *const *pages,
+                                    size_t num_pages);
+
+  // store the checksum of the first PAGE_DATA_SIZE bytes of page_data in its
+  // last PAGE_CHECKSUM_SIZE bytes
+  static void StampChecksum(char *page_data);
+  // whether page_data holds its checksum, or is all zeros
+  static bool VerifyChecksum(const char *page_data);
+
+  // the backend the asynchronous calls run on
+  AsyncIOBackend GetAsyncIOBackend();
+
+  inline DiskIOMode GetIOMode() const { return io_mode_; }
+
+  inline DiskCompression GetCompression() const { return compression_; }
+
+  // bytes of the file taken by the pages written, PAGE_SIZE per page unless
+  // compressed
+  size_t GetStoredSize();
+
+  // the page in the mapping of DISK_IO_MMAP, read-only. nullptr in the other
+  // modes or for a page past the mapped file
+  inline const char *GetMappedPage(page_id_t page_id) const {
+    if (page_id < 0 || static_cast<size_t>(page_id) >= num_mapped_pages_)
+      return nullptr;
+    return mapping_ + static_cast<size_t>(page_id) * PAGE_SIZE;
+  }
+
+  inline size_t GetNumMappedPages() const { return num_mapped_pages_; }
+
+  // hint how pages [first_page_id, first_page_id + num_pages) are going to
+  // be read, a no-op unless mapped
+  void AdvisePages(page_id_t first_page_id, size_t num_pages,
+                   DiskAdvice advice);
+
+  // a free page in the extent of hint, the first one at or after hint
+  // wrapping around within the extent, else the first page of a new extent.
+  // Without a hint the lowest free page. If no page is free the file grows
+  page_id_t AllocatePage(page_id_t hint = INVALID_PAGE_ID);
+  // make page_id free for AllocatePage to hand out again, pages that are not
+  // allocated are ignored
   void DeallocatePage(page_id_t page_id);
 
+  bool IsAllocated(page_id_t page_id);
+
+  // deallocated pages not handed out again yet
+  size_t GetNumFreePages();
+
+  // number of pages covered by the file, pages past it were never written
+  page_id_t GetNumPages();
+
 private:
-  int GetFileSize();
-  std::fstream db_io_;
+  // where a page is stored with DISK_COMPRESSION_LZ, as in the location map
+  struct PageLocation {
+    uint32_t first_slot;
+    // 0 if the page was never written
+    uint32_t num_slots;
+  };
+
+  static void CopyStamped(const char *const *pages, size_t count,
+                          char *buffer);
+
+  static uint32_t CompressPage(const char *page_data, char *slots);
+
+  static bool ExpandPage(const char *slots, uint32_t num_slots,
+                         char *page_data);
+
+  void WriteCompressedPage(page_id_t page_id, const char *page_data);
+
+  void ReadCompressedPage(page_id_t page_id, char *page_data);
+
+  void ReadCompressedPageAsync(page_id_t page_id, char *page_data,
+                               std::function<void(bool)> callback);
+
+  void ExtendFileSize(size_t size);
+
+  AsyncIOEngine *GetAsyncIOEngine();
+
+  void LoadFreeSpaceMap(bool is_new_file);
+
+  void MarkAllocated(page_id_t begin, page_id_t end);
+
+  void GrowAllocation(page_id_t end);
+
+  void ResizeMap(page_id_t end);
+
+  void SaveFreeSpaceMap();
+
+  page_id_t FindFreePage(page_id_t begin, page_id_t end);
+
+  void LoadLocationMap(bool is_new_file);
+
+  PageLocation GetLocation(page_id_t page_id);
+
+  uint32_t PlacePage(page_id_t page_id, uint32_t num_slots);
+
+  uint32_t AllocateSlots(uint32_t num_slots);
+
+  void ReleaseSlots(PageLocation location);
+
+  void FreeSlots(uint32_t first_slot, uint32_t num_slots);
+
+  bool SaveLocationMap();
+
+  // bit of page_id in bitmap_
+  inline uint64_t &GetBitmapWord(page_id_t page_id) {
+    return bitmap_[page_id / 64];
+  }
+  inline static uint64_t GetBitmapMask(page_id_t page_id) {
+    return uint64_t(1) << (page_id % 64);
+  }
+
+  // whether data has to be copied through an aligned buffer
+  inline bool NeedsBounce(const void *data) const {
+    return io_mode_ == DISK_IO_DIRECT &&
+           reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT != 0;
+  }
+
+  // all I/O is positional, so there is no shared cursor and concurrent reads
+  // and writes of different pages need no latch
+  int db_fd_;
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  DiskIOMode io_mode_;
+  DiskCompression compression_;
+  // the file mapped by DISK_IO_MMAP, nullptr otherwise
+  char *mapping_ = nullptr;
+  size_t num_mapped_pages_ = 0;
+  // size of the file for GetNumPages, stat once and then kept up to date by
+  // the writes. Writes through another DiskManager of the same file are not
+  // seen
+  std::atomic<size_t> file_size_;
+  // allocation state, see file comment
+  std::mutex allocation_mutex_;
+  // pages from here on are all free
+  page_id_t next_page_id_;
+  // a set bit for every allocated page, in whole map pages
+  std::vector<uint64_t> bitmap_;
+  // per map page, free pages below next_page_id_ and whether it has to be
+  // written
+  std::vector<size_t> free_counts_;
+  std::vector<bool> dirty_map_pages_;
+  size_t num_free_pages_ = 0;
+  // the file is preallocated up to this page, see GrowAllocation
+  page_id_t preallocated_end_ = 0;
+  // next_page_id_ as last written to the map
+  page_id_t saved_next_page_id_ = 0;
+  std::string fsm_file_name_;
+  // -1 until the map file exists
+  int fsm_fd_ = -1;
+  // slots of DISK_COMPRESSION_LZ, see file comment
+  std::mutex location_mutex_;
+  std::vector<PageLocation> locations_;
+  // per map page, whether it has to be written
+  std::vector<bool> dirty_location_pages_;
+  // free runs of slots by their length, and the slots from here on
+  std::vector<std::vector<uint32_t>> free_slots_;
+  uint32_t next_slot_ = 0;
+  // runs left by moved pages, free once the map is synced
+  std::vector<PageLocation> released_slots_;
+  // slots taken by the pages
+  size_t num_used_slots_ = 0;
+  // locations_.size() as last written to the map, SIZE_MAX before
+  size_t saved_num_locations_ = SIZE_MAX;
+  std::string location_file_name_;
+  // -1 without compression
+  int location_fd_ = -1;
+  // set up on the first asynchronous call
+  AsyncIOBackend async_io_backend_;
+  std::mutex async_io_mutex_;
+  std::atomic<AsyncIOEngine *> async_io_{nullptr};
 };
 
 } // namespace cmudb
@@ -10,8 +10,11 @@
 #pragma once
 
 #include <cstdlib>
-#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "hash/hash_table.h"
 
@@ -19,6 +22,14 @@ namespace cmudb {
 
 template <typename K, typename V>
 class ExtendibleHash : public HashTable<K, V> {
+  // a bucket holds at most bucket_size_ entries sharing the low local_depth
+  // bits of their hash
+  struct Bucket {
+    Bucket(int depth) : local_depth(depth) {}
+    int local_depth;
+    std::map<K, V> items;
+  };
+
 public:
   // constructor
   ExtendibleHash(size_t size);
@@ -34,6 +45,13 @@ public:
   void Insert(const K &key, const V &value) override;
 
 private:
-  // add your own member variables here
+  size_t BucketIndex(const K &key);
+
+  size_t bucket_size_;
+  int global_depth_;
+  int num_buckets_;
+  // directory of 2^global_depth_ slots, several slots may share one bucket
+  std::vector<std::shared_ptr<Bucket>> directory_;
+  mutable std::mutex latch_;
 };
 } // namespace cmudb
@@ -0,0 +1,57 @@
+/**
+ * page_table.h
+ *
+ * Functionality: Fixed-capacity open addressing (linear probing) hash table
+ * mapping page ids to frames, built for the buffer pool's hit path.
+ *
+ * Find is lock-free and may run concurrently with Insert/Remove. Insert and
+ * Remove must be serialized by the caller (the buffer pool instance latch).
+ * A concurrent Find may miss an entry that is being moved, or return a frame
+ * whose mapping was just removed, so lock-free callers must validate the
+ * frame and fall back to a latched lookup on a miss.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "hash/hash_table.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+class PageTable : public HashTable<page_id_t, Page *> {
+  // slot key of a removed entry, probing continues past it
+  static const page_id_t TOMBSTONE_PAGE_ID = -2;
+
+  struct Slot {
+    std::atomic<page_id_t> key{INVALID_PAGE_ID};
+    std::atomic<Page *> value{nullptr};
+  };
+
+public:
+  // capacity: maximum number of entries (e.g. number of frames)
+  PageTable(size_t capacity);
+
+  bool Find(const page_id_t &page_id, Page *&page) override;
+  bool Remove(const page_id_t &page_id) override;
+  void Insert(const page_id_t &page_id, Page *const &page) override;
+
+private:
+  inline size_t HashKey(page_id_t page_id) const {
+    // fibonacci hashing spreads consecutive page ids over the table
+    return (static_cast<uint32_t>(page_id) * 2654435769U) & mask_;
+  }
+
+  void Rebuild();
+
+  size_t capacity_;
+  size_t mask_;
+  std::vector<Slot> slots_;
+  // only touched by writers
+  size_t num_entries_;
+  size_t num_tombstones_;
+};
+
+} // namespace cmudb
@@ -61,6 +61,9 @@ namespace cmudb {
                             Transaction *transaction = nullptr);
 
     private:
+        typedef B_PLUS_TREE_LEAF_PAGE_TYPE LeafPage;
+        typedef BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> InternalPage;
+
         void StartNewTree(const KeyType &key, const ValueType &value);
 
         bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
@@ -94,7 +97,7 @@ namespace cmudb {
         bool GetValueHelper(const KeyType &key,
                             std::vector<ValueType> &result,
                             page_id_t pageId);
-        void InsertToLeaf(page_id_t leafId, const KeyType &key, const ValueType &value);
+        void InsertToLeaf(LeafPage *page, const KeyType &key, const ValueType &value);
 //        void insertToInternal(page_id_t page_id, const ValueType &old_value, const KeyType &key, const ValueType &value);
         // member variable
         std::string index_name_;
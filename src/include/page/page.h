@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -20,7 +21,8 @@ class Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  // the buffer pool manager assigns the frame data
+  Page() {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
@@ -34,10 +36,16 @@ private:
   // method used by buffer pool manager
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
+  // actual data, a frame of the buffer pool's FrameArena, kept apart from the
+  // metadata so that frames are 4KB aligned and densely packed
+  char *data_ = nullptr;
+  // metadata is read without the buffer pool latch on the FetchPage hit path,
+  // pin_count_ is -1 while the frame is being evicted
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
+  std::atomic<bool> is_dirty_{false};
+  // owned by a BufferRing, kept out of the replacer
+  std::atomic<bool> is_ring_frame_{false};
   RWMutex rwlatch_;
 };
 
@@ -39,18 +39,26 @@ public:
 
   bool DeleteTableHeap();
 
-  TableIterator begin();
+  // use_buffer_ring: read the pages through a private BufferRing, for large
+  // scans that should not flush the buffer pool. Such scans do not read
+  // ahead. Ignored for a mapped file, see BufferPoolManager
+  TableIterator begin(bool use_buffer_ring = false);
 
   TableIterator end();
 
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  // number of pages iterators read ahead once they see the heap pages are
+  // laid out sequentially on disk, 0 disables read-ahead
+  inline void SetReadAheadPages(size_t pages) { read_ahead_pages_ = pages; }
+
 private:
   /**
    * Members
    */
   BufferPoolManager *buffer_pool_manager_;
   page_id_t first_page_id_;
+  size_t read_ahead_pages_ = READ_AHEAD_PAGES;
 };
 
 } // namespace cmudb
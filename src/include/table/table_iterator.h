@@ -7,7 +7,10 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_ring.h"
+#include "buffer/read_ahead.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +22,9 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid);
+  // buffer_ring: if set, pages are read through it, see TableHeap::begin
+  TableIterator(TableHeap *table_heap, RID rid,
+                std::shared_ptr<BufferRing> buffer_ring = nullptr);
 
   ~TableIterator() { delete tuple_; }
 
@@ -42,6 +47,9 @@ public:
 private:
   TableHeap *table_heap_;
   Tuple *tuple_;
+  // shared by the copies of an iterator
+  std::shared_ptr<BufferRing> buffer_ring_;
+  ReadAhead read_ahead_;
 };
 
 } // namespace cmudb
\ No newline at end of file
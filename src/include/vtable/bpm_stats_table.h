@@ -0,0 +1,29 @@
+/**
+ * bpm_stats_table.h
+ *
+ * Read-only eponymous virtual tables over the telemetry of the buffer pool
+ * manager, available without CREATE VIRTUAL TABLE:
+ *   SELECT * FROM bpm_stats;       -- name, value of every counter
+ *   SELECT * FROM bpm_page_heat;   -- page_id, accesses, hottest first
+ * Every scan reads a fresh snapshot. Page accesses are only counted while
+ * enabled with SELECT vtable_page_heat(1), or VTABLE_PAGE_HEAT=1 in the
+ * environment when the extension is loaded.
+ */
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "sqlite/sqlite3ext.h"
+
+namespace cmudb {
+
+// register both tables and vtable_page_heat() with db
+int RegisterBufferPoolStatsTables(sqlite3 *db,
+                                  BufferPoolManager *buffer_pool_manager);
+
+// SQL function vtable_page_heat([enabled]), works like a pragma: turn the
+// per page access counters on or off if an argument is given, return
+// whether they are on
+void PageHeatFunction(sqlite3_context *ctx, int argc, sqlite3_value **argv);
+
+} // namespace cmudb
@@ -26,6 +26,20 @@ Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
                       page_id_t root_id = INVALID_PAGE_ID);
 
+bool ParseFrameCount(const char *value, size_t &frame_count);
+
+// module arguments after the schema are the quoted index definition and
+// options of the form key=value, return nullptr if there is no index
+bool IsModuleOption(const char *argument);
+
+const char *FindIndexArgument(int argc, const char *const *argv);
+
+bool ApplyModuleOptions(BufferPoolManager *buffer_pool_manager, int argc,
+                        const char *const *argv, char **pzErr);
+
+// SQL function vtable_pool_size([frames])
+void PoolSizeFunction(sqlite3_context *ctx, int argc, sqlite3_value **argv);
+
 /* API declaration */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr);
@@ -108,7 +122,9 @@ public:
     return table_heap_->UpdateTuple(tuple, rid);
   }
 
-  inline TableIterator begin() { return table_heap_->begin(); }
+  inline TableIterator begin(bool use_buffer_ring = false) {
+    return table_heap_->begin(use_buffer_ring);
+  }
 
   inline TableIterator end() { return table_heap_->end(); }
 
@@ -130,9 +146,11 @@ private:
 
 class Cursor {
 public:
+  // full table scans go through a buffer ring, so that they do not flush
+  // the pages of other queries out of the (small) buffer pool
   Cursor(VirtualTable *virtual_table)
-      : table_iterator_(virtual_table->begin()), virtual_table_(virtual_table) {
-  }
+      : table_iterator_(virtual_table->begin(true)),
+        virtual_table_(virtual_table) {}
 
   inline void SetScanFlag(bool is_index_scan) {
     is_index_scan_ = is_index_scan;
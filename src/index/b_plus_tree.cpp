@@ -3,6 +3,7 @@
  */
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -37,6 +38,9 @@ namespace cmudb {
     bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                                   std::vector<ValueType> &result,
                                   Transaction *transaction) {
+        if (IsEmpty()) {
+            return false;
+        }
         return GetValueHelper(key, result, root_page_id_);
     }
 
@@ -44,27 +48,25 @@ namespace cmudb {
     bool BPLUSTREE_TYPE::GetValueHelper(const KeyType &key,
                                         std::vector<ValueType> &result,
                                         page_id_t pageId) {
-
-        BPlusTreePage *currPage = (BPlusTreePage *) buffer_pool_manager_->FetchPage(pageId);
-        if (currPage->IsLeafPage()) {
-            BPlusTreeLeafPage *currLeaf = (BPlusTreeLeafPage *) currPage;
-            ValueType value;
-            if (currLeaf->Lookup(key, value, comparator_)) {
-                result.push_back(value);
-                return true;
-            } else {
-                return false;
-            }
-        } else {
-            BPlusTreeInternalPage *currInternal = (BPlusTreeInternalPage *) currPage;
-            // TODO: bi-search
-            for (int i = 1; i < currInternal->GetSize(); i++) {
-                if (comparator_.operator()(key, currInternal->KeyAt(i)) < 0) {
-                    return GetValueHelper(key, result, currInternal->ValueAt(i - 1));
-                }
-            }
-            return GetValueHelper(key, result, currInternal->ValueAt(currInternal->GetSize() - 1));
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(pageId);
+        if (!guard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while searching");
+        while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+            page_id_t childId = guard.As<InternalPage>()->Lookup(key, comparator_);
+            // the parent is released once the child is latched
+            ReadPageGuard childGuard = buffer_pool_manager_->FetchPageRead(childId);
+            if (!childGuard.IsValid())
+                throw Exception(EXCEPTION_TYPE_INDEX,
+                                "all page are pinned while searching");
+            guard = std::move(childGuard);
         }
+        ValueType value;
+        if (guard.As<LeafPage>()->Lookup(key, value, comparator_)) {
+            result.push_back(value);
+            return true;
+        }
+        return false;
     }
 
 /*****************************************************************************
@@ -91,8 +93,7 @@ namespace cmudb {
 //            return false;
 //        }
 
-        InsertIntoLeaf(key, value, transaction);
-        return true;
+        return InsertIntoLeaf(key, value, transaction);
     }
 
 /*
@@ -103,11 +104,10 @@ namespace cmudb {
  */
     INDEX_TEMPLATE_ARGUMENTS
     void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-        // TODO: right way to create page?
-        BPlusTreeLeafPage* root = (BPlusTreeLeafPage*)buffer_pool_manager_->NewPage(root_page_id_);
-        if (root == nullptr) {
-            // TODO: throw exception
-        }
+        WritePageGuard guard = buffer_pool_manager_->NewPageWrite(root_page_id_);
+        if (!guard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+        LeafPage *root = guard.AsMut<LeafPage>();
         root->Init(root_page_id_, INVALID_PAGE_ID);
         root->Insert(key, value, comparator_);
     }
@@ -123,42 +123,39 @@ namespace cmudb {
     INDEX_TEMPLATE_ARGUMENTS
     bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                         Transaction *transaction) {
-        page_id_t currId = root_page_id_;
-        while (true) {
-            BPlusTreePage *page = (BPlusTreePage *) buffer_pool_manager_->FetchPage(currId);
-            if (page->IsLeafPage()) {
-                break;
-            }
-            BPlusTreeInternalPage *internalPage = (BPlusTreeInternalPage *) page;
-            // TODO: bi-search
-            for (int i = 1; i < internalPage->GetSize(); i++) {
-                if (comparator_.operator()(key, internalPage->KeyAt(i)) < 0) {
-                    currId = internalPage->ValueAt(i - 1);
-                    continue;
-                }
-            }
-            currId = internalPage->ValueAt(internalPage->GetSize() - 1);
+        // write latches all the way down, the leaf cannot be upgraded later
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(root_page_id_);
+        if (!guard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+        while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+            page_id_t childId = guard.As<InternalPage>()->Lookup(key, comparator_);
+            WritePageGuard childGuard = buffer_pool_manager_->FetchPageWrite(childId);
+            if (!childGuard.IsValid())
+                throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+            guard = std::move(childGuard);
         }
-        BPlusTreeLeafPage* curr = (BPlusTreeLeafPage*) buffer_pool_manager_->FetchPage(currId);
         ValueType v;
-        if (curr->Lookup(key, v, comparator_)) {
+        if (guard.As<LeafPage>()->Lookup(key, v, comparator_)) {
             return false;
         }
-        InsertToLeaf(currId, key, value);
+        InsertToLeaf(guard.AsMut<LeafPage>(), key, value);
         return true;
     }
 
     INDEX_TEMPLATE_ARGUMENTS
-    void BPLUSTREE_TYPE::InsertToLeaf(page_id_t leafId, const KeyType &key, const ValueType &value) {
-        BPlusTreeLeafPage *page = (BPlusTreeLeafPage *) buffer_pool_manager_->FetchPage(leafId);
+    void BPLUSTREE_TYPE::InsertToLeaf(LeafPage *page, const KeyType &key, const ValueType &value) {
         page->Insert(key, value, comparator_);
         if (page->GetSize() < page->GetMaxSize())
             return;
         page_id_t newPageId;
-        BPlusTreeLeafPage *newPage = (BPlusTreeLeafPage *) buffer_pool_manager_->NewPage(newPageId);
+        // the sibling goes next to the page on disk, a range scan reads both
+        WritePageGuard newGuard = buffer_pool_manager_->NewPageWrite(newPageId, page->GetPageId());
+        if (!newGuard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+        LeafPage *newPage = newGuard.AsMut<LeafPage>();
         newPage->Init(newPageId, page->GetParentPageId());
         page->MoveHalfTo(newPage, buffer_pool_manager_);
-        InsertIntoParent(page,newPage->KeyAt(0), newPage);
+        InsertIntoParent(page, newPage->KeyAt(0), newPage);
     }
 
 /*
@@ -186,17 +183,26 @@ namespace cmudb {
                                           const KeyType &key,
                                           BPlusTreePage *new_node,
                                           Transaction *transaction) {
-        BPlusTreeInternalPage *page = (BPlusTreeInternalPage *) buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(old_node->GetParentPageId());
+        if (!guard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+        InternalPage *page = guard.AsMut<InternalPage>();
         page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
         if (page->GetSize() < page->GetMaxSize()) {
             return;
         }
         page_id_t newId;
-        BPlusTreeInternalPage* newPage = (BPlusTreeInternalPage*)buffer_pool_manager_->NewPage(newId);
+        WritePageGuard newGuard = buffer_pool_manager_->NewPageWrite(newId, page->GetPageId());
+        if (!newGuard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+        InternalPage *newPage = newGuard.AsMut<InternalPage>();
         page->MoveHalfTo(newPage, buffer_pool_manager_);
         if (page->IsRootPage()) {
-            BPlusTreeInternalPage* newRoot =  (BPlusTreeInternalPage*)buffer_pool_manager_->NewPage(root_page_id_);
-            newRoot->PopulateNewRoot(page->GetPageId(), newPage->KeyAt(0), newPage->ValueAt(0));
+            WritePageGuard rootGuard = buffer_pool_manager_->NewPageWrite(root_page_id_, page->GetPageId());
+            if (!rootGuard.IsValid())
+                throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+            InternalPage *newRoot = rootGuard.AsMut<InternalPage>();
+            newRoot->PopulateNewRoot(page->GetPageId(), newPage->KeyAt(0), newPage->GetPageId());
         } else {
             InsertIntoParent(page, newPage->KeyAt(0), newPage, transaction);
         }
@@ -338,15 +344,17 @@ namespace cmudb {
  */
     INDEX_TEMPLATE_ARGUMENTS
     void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-        HeaderPage *header_page = static_cast<HeaderPage *>(
-                buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+        if (!guard.IsValid())
+            throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+        HeaderPage *header_page = static_cast<HeaderPage *>(guard.GetPage());
         if (insert_record)
             // create a new record<index_name + root_page_id> in header_page
             header_page->InsertRecord(index_name_, root_page_id_);
         else
             // update root_page_id in header_page
             header_page->UpdateRecord(index_name_, root_page_id_);
-        buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+        guard.SetDirty();
     }
 
 /*
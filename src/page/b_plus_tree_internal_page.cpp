@@ -23,7 +23,7 @@ namespace cmudb {
         SetSize(0);
         SetPageId(page_id);
         SetParentPageId(parent_id);
-        SetMaxSize((PAGE_SIZE - HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)));
+        SetMaxSize((PAGE_DATA_SIZE - HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)));
     }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
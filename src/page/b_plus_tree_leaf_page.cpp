@@ -28,7 +28,7 @@ namespace cmudb {
         SetParentPageId(parent_id);
         // TODO: what is next page id
         SetNextPageId(INVALID_PAGE_ID);
-        SetMaxSize((PAGE_SIZE - HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)));
+        SetMaxSize((PAGE_DATA_SIZE - HEADER_SIZE) / (sizeof(KeyType) + sizeof(ValueType)));
     }
 
 /**
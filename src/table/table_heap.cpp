@@ -3,6 +3,8 @@
  */
 
 #include <cassert>
+#include <memory>
+#include <utility>
 
 #include "common/logger.h"
 #include "table/table_heap.h"
@@ -13,80 +15,80 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
                      page_id_t first_page_id)
     : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id) {
   if (first_page_id_ == INVALID_PAGE_ID) {
-    auto first_page =
-        static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
-    assert(first_page != nullptr); // todo: abort table creation?
+    auto first_page_guard = buffer_pool_manager_->NewPageWrite(first_page_id_);
+    assert(first_page_guard.IsValid()); // todo: abort table creation?
     LOG_DEBUG("new table page created %d", first_page_id_);
 
-    first_page->Init(first_page_id_, PAGE_SIZE);
-    buffer_pool_manager_->UnpinPage(first_page_id_, true);
+    auto first_page = static_cast<TablePage *>(first_page_guard.GetPage());
+    first_page->Init(first_page_id_, PAGE_DATA_SIZE);
   }
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid) {
-  if (tuple.size_ + 28 > PAGE_SIZE) // larger than one page size
+  if (tuple.size_ + 28 > PAGE_DATA_SIZE) // larger than one page size
     return false;
 
-  auto cur_page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  auto cur_page_guard = buffer_pool_manager_->FetchPageWrite(first_page_id_);
+  if (!cur_page_guard.IsValid())
+    return false;
+  auto cur_page = static_cast<TablePage *>(cur_page_guard.GetPage());
 
   while (!cur_page->InsertTuple(
       tuple, rid)) { // fail to insert due to not enough space
     auto next_page_id = cur_page->GetNextPageId();
     if (next_page_id != INVALID_PAGE_ID) { // valid next page
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = static_cast<TablePage *>(
-          buffer_pool_manager_->FetchPage(next_page_id));
-    } else { // create new page
-      auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
-      assert(new_page != nullptr); // todo: abort when all pages are pinned?
-      // std::cout << "new table page " << next_page_id << " created" <<
-      // std::endl;
+      // latch coupling: release the current page only once the next one is
+      // latched, so nobody links a second page in between
+      auto next_page_guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+      if (!next_page_guard.IsValid())
+        return false;
+      cur_page_guard = std::move(next_page_guard);
+    } else { // create new page, next to the current one on disk
+      auto new_page_guard = buffer_pool_manager_->NewPageWrite(
+          next_page_id, cur_page->GetPageId());
+      if (!new_page_guard.IsValid()) // all pages are pinned
+        return false;
+      auto new_page = static_cast<TablePage *>(new_page_guard.GetPage());
       cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetPageId(),
+      new_page->Init(next_page_id, PAGE_DATA_SIZE, cur_page->GetPageId(),
                      INVALID_PAGE_ID);
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
-      cur_page = new_page;
+      cur_page_guard.SetDirty();
+      cur_page_guard = std::move(new_page_guard);
     }
+    cur_page = static_cast<TablePage *>(cur_page_guard.GetPage());
   }
-  buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
+  cur_page_guard.SetDirty();
   return true;
 }
 
 bool TableHeap::DeleteTuple(const RID &rid) {
   // todo: remove empty page
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
-    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+  auto page_guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!page_guard.IsValid())
     return false;
-  }
+  auto page = static_cast<TablePage *>(page_guard.GetPage());
   bool is_deleted = page->DeleteTuple(rid);
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), is_deleted);
+  if (is_deleted)
+    page_guard.SetDirty();
   return is_deleted;
 }
 
 bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
-    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+  auto page_guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!page_guard.IsValid())
     return false;
-  }
+  auto page = static_cast<TablePage *>(page_guard.GetPage());
   bool is_updated = page->UpdateTuple(tuple, rid);
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), is_updated);
+  if (is_updated)
+    page_guard.SetDirty();
   return is_updated;
 }
 
 bool TableHeap::GetTuple(const RID &rid, Tuple &tuple) {
-  auto page = static_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr)
+  auto page_guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
+  if (!page_guard.IsValid())
     return false;
-  bool res = page->GetTuple(rid, tuple);
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return static_cast<TablePage *>(page_guard.GetPage())->GetTuple(rid, tuple);
 }
 
 bool TableHeap::DeleteTableHeap() {
@@ -94,14 +96,20 @@ bool TableHeap::DeleteTableHeap() {
   return true;
 }
 
-TableIterator TableHeap::begin() {
-  auto page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+TableIterator TableHeap::begin(bool use_buffer_ring) {
+  std::shared_ptr<BufferRing> buffer_ring;
+  // a mapped file has no frames to protect, the scan reads ahead instead
+  if (use_buffer_ring && buffer_pool_manager_->GetIOMode() != DISK_IO_MMAP)
+    buffer_ring = std::make_shared<BufferRing>(buffer_pool_manager_);
   RID rid; // if failed (no tuple), rid will be the result of default
   // constructor, which means eof
-  page->GetFirstTupleRid(rid);
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid);
+  {
+    auto page_guard =
+        buffer_pool_manager_->FetchPageRead(first_page_id_, buffer_ring.get());
+    assert(page_guard.IsValid()); // all pages are pinned
+    static_cast<TablePage *>(page_guard.GetPage())->GetFirstTupleRid(rid);
+  }
+  return TableIterator(this, rid, buffer_ring);
 }
 
 TableIterator TableHeap::end() {
@@ -9,9 +9,15 @@
 
 namespace cmudb {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid,
+                             std::shared_ptr<BufferRing> buffer_ring)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)),
+      buffer_ring_(buffer_ring),
+      // read-ahead would bring the pages into the shared pool
+      read_ahead_(table_heap->buffer_pool_manager_,
+                  buffer_ring ? 0 : table_heap->read_ahead_pages_) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
+    read_ahead_.OnPageAccess(rid.GetPageId());
     table_heap_->GetTuple(tuple_->rid_, *tuple_);
   }
 };
@@ -28,30 +34,35 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  assert(cur_page != nullptr); // all pages are pinned
+  auto page_guard = buffer_pool_manager->FetchPageRead(
+      tuple_->rid_.GetPageId(), buffer_ring_.get());
+  assert(page_guard.IsValid()); // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(page_guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
-    if (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+    page_id_t next_page_id = cur_page->GetNextPageId();
+    if (next_page_id != INVALID_PAGE_ID) {
+      read_ahead_.OnPageAccess(next_page_id);
+      // the current page is released once the next one is latched
+      page_guard =
+          buffer_pool_manager->FetchPageRead(next_page_id, buffer_ring_.get());
+      assert(page_guard.IsValid()); // all pages are pinned
+      cur_page = static_cast<TablePage *>(page_guard.GetPage());
       // return value could be false
       // when you delete a tuple from certain page and no tuples remain valid
       // within that page
-      next_page->GetFirstTupleRid(next_tuple_rid);
-      buffer_pool_manager->UnpinPage(cur_page->GetNextPageId(), false);
+      cur_page->GetFirstTupleRid(next_tuple_rid);
     } else {
       next_tuple_rid.Set(INVALID_PAGE_ID, -1); // EOF
     }
   }
-  buffer_pool_manager->UnpinPage(tuple_->rid_.GetPageId(), false);
   tuple_->rid_ = next_tuple_rid;
 
+  // the tuple is on the page still latched, no second fetch needed
   if (*this != table_heap_->end()) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_);
+    cur_page->GetTuple(tuple_->rid_, *tuple_);
   }
   return *this;
 }
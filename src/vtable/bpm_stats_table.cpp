@@ -0,0 +1,207 @@
+/**
+ * bpm_stats_table.cpp
+ */
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vtable/bpm_stats_table.h"
+
+namespace cmudb {
+
+SQLITE_EXTENSION_INIT3
+
+enum StatsTableType { STATS_TABLE_COUNTERS = 0, STATS_TABLE_PAGE_HEAT };
+
+struct StatsTable {
+  sqlite3_vtab base; // must come first, sqlite hands out pointers to it
+  BufferPoolManager *buffer_pool_manager;
+  StatsTableType type;
+};
+
+struct StatsCursor {
+  sqlite3_vtab_cursor base; // must come first
+  BufferPoolStatistics stats;
+  std::vector<std::pair<page_id_t, uint64_t>> heat;
+  size_t row;
+  size_t num_rows;
+};
+
+static int StatsConnect(sqlite3 *db, void *pAux, StatsTableType type,
+                        sqlite3_vtab **ppVtab) {
+  const char *schema = type == STATS_TABLE_COUNTERS
+                           ? "CREATE TABLE x(name TEXT, value INTEGER)"
+                           : "CREATE TABLE x(page_id INTEGER, accesses "
+                             "INTEGER)";
+  int rc = sqlite3_declare_vtab(db, schema);
+  if (rc != SQLITE_OK)
+    return rc;
+  StatsTable *table = new StatsTable();
+  table->buffer_pool_manager = reinterpret_cast<BufferPoolManager *>(pAux);
+  table->type = type;
+  *ppVtab = &table->base;
+  return SQLITE_OK;
+}
+
+static int CountersConnect(sqlite3 *db, void *pAux, int argc,
+                           const char *const *argv, sqlite3_vtab **ppVtab,
+                           char **pzErr) {
+  return StatsConnect(db, pAux, STATS_TABLE_COUNTERS, ppVtab);
+}
+
+static int PageHeatConnect(sqlite3 *db, void *pAux, int argc,
+                           const char *const *argv, sqlite3_vtab **ppVtab,
+                           char **pzErr) {
+  return StatsConnect(db, pAux, STATS_TABLE_PAGE_HEAT, ppVtab);
+}
+
+static int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  // no constraints are used, always a full scan of the snapshot
+  return SQLITE_OK;
+}
+
+static int StatsDisconnect(sqlite3_vtab *pVtab) {
+  delete reinterpret_cast<StatsTable *>(pVtab);
+  return SQLITE_OK;
+}
+
+static int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  StatsCursor *cursor = new StatsCursor();
+  *ppCursor = &cursor->base;
+  return SQLITE_OK;
+}
+
+static int StatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<StatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+/*
+ * Take the snapshot the scan reports
+ */
+static int StatsFilter(sqlite3_vtab_cursor *cur, int idxNum,
+                       const char *idxStr, int argc, sqlite3_value **argv) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(cur);
+  StatsTable *table = reinterpret_cast<StatsTable *>(cur->pVtab);
+  cursor->row = 0;
+  if (table->type == STATS_TABLE_COUNTERS) {
+    cursor->stats = table->buffer_pool_manager->GetStatistics();
+    cursor->num_rows = BPM_COUNTER_COUNT;
+  } else {
+    cursor->heat = table->buffer_pool_manager->GetPageHeat();
+    cursor->num_rows = cursor->heat.size();
+  }
+  return SQLITE_OK;
+}
+
+static int StatsNext(sqlite3_vtab_cursor *cur) {
+  reinterpret_cast<StatsCursor *>(cur)->row++;
+  return SQLITE_OK;
+}
+
+static int StatsEof(sqlite3_vtab_cursor *cur) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(cur);
+  return cursor->row >= cursor->num_rows;
+}
+
+static int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(cur);
+  StatsTable *table = reinterpret_cast<StatsTable *>(cur->pVtab);
+  if (table->type == STATS_TABLE_COUNTERS) {
+    BufferPoolCounter counter = static_cast<BufferPoolCounter>(cursor->row);
+    if (i == 0)
+      sqlite3_result_text(ctx, BufferPoolCounterName(counter), -1,
+                          SQLITE_STATIC);
+    else
+      sqlite3_result_int64(ctx, GetCounterValue(cursor->stats, counter));
+  } else {
+    const auto &entry = cursor->heat[cursor->row];
+    sqlite3_result_int64(ctx, i == 0 ? entry.first : entry.second);
+  }
+  return SQLITE_OK;
+}
+
+static int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  *pRowid = reinterpret_cast<StatsCursor *>(cur)->row;
+  return SQLITE_OK;
+}
+
+// without xCreate the tables are eponymous-only, and without xUpdate they
+// are read-only
+static sqlite3_module CountersModule = {
+    0,               /* iVersion */
+    0,               /* xCreate */
+    CountersConnect, /* xConnect */
+    StatsBestIndex,  /* xBestIndex */
+    StatsDisconnect, /* xDisconnect */
+    StatsDisconnect, /* xDestroy */
+    StatsOpen,       /* xOpen - open a cursor */
+    StatsClose,      /* xClose - close a cursor */
+    StatsFilter,     /* xFilter - configure scan constraints */
+    StatsNext,       /* xNext - advance a cursor */
+    StatsEof,        /* xEof - check for end of scan */
+    StatsColumn,     /* xColumn - read data */
+    StatsRowid,      /* xRowid - read data */
+    0,               /* xUpdate */
+    0,               /* xBegin */
+    0,               /* xSync */
+    0,               /* xCommit */
+    0,               /* xRollback */
+    0,               /* xFindMethod */
+    0,               /* xRename */
+    0,               /* xSavepoint */
+    0,               /* xRelease */
+    0,               /* xRollbackTo */
+};
+
+static sqlite3_module PageHeatModule = {
+    0,               /* iVersion */
+    0,               /* xCreate */
+    PageHeatConnect, /* xConnect */
+    StatsBestIndex,  /* xBestIndex */
+    StatsDisconnect, /* xDisconnect */
+    StatsDisconnect, /* xDestroy */
+    StatsOpen,       /* xOpen - open a cursor */
+    StatsClose,      /* xClose - close a cursor */
+    StatsFilter,     /* xFilter - configure scan constraints */
+    StatsNext,       /* xNext - advance a cursor */
+    StatsEof,        /* xEof - check for end of scan */
+    StatsColumn,     /* xColumn - read data */
+    StatsRowid,      /* xRowid - read data */
+    0,               /* xUpdate */
+    0,               /* xBegin */
+    0,               /* xSync */
+    0,               /* xCommit */
+    0,               /* xRollback */
+    0,               /* xFindMethod */
+    0,               /* xRename */
+    0,               /* xSavepoint */
+    0,               /* xRelease */
+    0,               /* xRollbackTo */
+};
+
+int RegisterBufferPoolStatsTables(sqlite3 *db,
+                                  BufferPoolManager *buffer_pool_manager) {
+  int rc = sqlite3_create_module(db, "bpm_stats", &CountersModule,
+                                 buffer_pool_manager);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_module(db, "bpm_page_heat", &PageHeatModule,
+                               buffer_pool_manager);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_function(db, "vtable_page_heat", 0, SQLITE_UTF8,
+                                 buffer_pool_manager, PageHeatFunction, 0, 0);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_function(db, "vtable_page_heat", 1, SQLITE_UTF8,
+                                 buffer_pool_manager, PageHeatFunction, 0, 0);
+  return rc;
+}
+
+void PageHeatFunction(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+  BufferPoolManager *buffer_pool_manager =
+      reinterpret_cast<BufferPoolManager *>(sqlite3_user_data(ctx));
+  if (argc == 1)
+    buffer_pool_manager->SetPageHeatTracking(sqlite3_value_int(argv[0]) != 0);
+  sqlite3_result_int(ctx, buffer_pool_manager->IsPageHeatTracking());
+}
+
+} // namespace cmudb
@@ -1,7 +1,26 @@
 /**
  * virtual_table.cpp
+ *
+ * The buffer pool shared by all virtual tables is configured through the
+ * environment when the extension is loaded:
+ *   VTABLE_DB_FILE        database file, vtable.db by default
+ *   VTABLE_POOL_SIZE      frames of the buffer pool, 10 by default
+ *   VTABLE_MAX_POOL_SIZE  frames the pool may grow to, 1024 by default
+ *   VTABLE_PAGE_HEAT      1 to count the accesses of every page, see
+ *                         bpm_stats_table.h for the statistics tables
+ *   VTABLE_WARMUP_FILE    pages cached when the pool is flushed, reloaded
+ *                         on startup, <db file>.warmup by default, empty to
+ *                         disable
+ *   VTABLE_DIRECT_IO      1 to open the database file with O_DIRECT, so its
+ *                         pages are not cached by the kernel as well
+ *   VTABLE_COMPRESSION    1 to store the pages compressed, a database file
+ *                         has to be opened the way it was created
+ * The pool can be resized online up to that budget, with the option
+ * pool_size=<frames> of CREATE VIRTUAL TABLE ... USING vtable(...), or with
+ * SELECT vtable_pool_size(<frames>). vtable_pool_size() returns the size.
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <sys/stat.h>
@@ -11,6 +30,7 @@
 #include "common/logger.h"
 #include "common/string_utility.h"
 #include "page/header_page.h"
+#include "vtable/bpm_stats_table.h"
 #include "vtable/virtual_table.h"
 
 namespace cmudb {
@@ -22,21 +42,25 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr) {
   BufferPoolManager *buffer_pool_manager =
       reinterpret_cast<BufferPoolManager *>(pAux);
+  // the first three parameter:(1) module name (2) database name (3)table name
+  assert(argc >= 4);
+  // resize before anything is pinned
+  if (!ApplyModuleOptions(buffer_pool_manager, argc, argv, pzErr))
+    return SQLITE_ERROR;
   // fetch header page from buffer pool
   HeaderPage *header_page =
       static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
 
-  // the first three parameter:(1) module name (2) database name (3)table name
-  assert(argc >= 4);
   // parse arg[3](string that defines table schema)
   std::string schema_string(argv[3]);
   schema_string = schema_string.substr(1, (schema_string.size() - 2));
   Schema *schema = ParseCreateStatement(schema_string);
 
-  // parse arg[4](string that defines table index)
+  // parse the string that defines table index
   Index *index = nullptr;
-  if (argc > 4) {
-    std::string index_string(argv[4]);
+  const char *index_argument = FindIndexArgument(argc, argv);
+  if (index_argument != nullptr) {
+    std::string index_string(index_argument);
     index_string = index_string.substr(1, (index_string.size() - 2));
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
@@ -68,16 +92,21 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   Schema *schema = ParseCreateStatement(schema_string);
   BufferPoolManager *buffer_pool_manager =
       reinterpret_cast<BufferPoolManager *>(pAux);
+  if (!ApplyModuleOptions(buffer_pool_manager, argc, argv, pzErr)) {
+    delete schema;
+    return SQLITE_ERROR;
+  }
 
   // Retrieve table root page info from header page
   HeaderPage *header_page =
       static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
   page_id_t table_root_id;
   header_page->GetRootId(std::string(argv[2]), table_root_id);
-  // parse arg[4](string that defines table index)
+  // parse the string that defines table index
   Index *index = nullptr;
-  if (argc > 4) {
-    std::string index_string(argv[4]);
+  const char *index_argument = FindIndexArgument(argc, argv);
+  if (index_argument != nullptr) {
+    std::string index_string(index_argument);
     index_string = index_string.substr(1, (index_string.size() - 2));
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
@@ -306,13 +335,38 @@ __declspec(dllexport)
 #endif
     extern "C" int sqlite3_vtable_init(sqlite3 *db, char **pzErrMsg,
                                        const sqlite3_api_routines *pApi) {
-  std::string file_name = "vtable.db";
+  SQLITE_EXTENSION_INIT2(pApi);
+  // configuration, see file comment
+  const char *env_file_name = getenv("VTABLE_DB_FILE");
+  std::string file_name = env_file_name != nullptr ? env_file_name : "vtable.db";
+  size_t pool_size = 10;
+  size_t max_pool_size = 1024;
+  if (!ParseFrameCount(getenv("VTABLE_POOL_SIZE"), pool_size) ||
+      !ParseFrameCount(getenv("VTABLE_MAX_POOL_SIZE"), max_pool_size)) {
+    *pzErrMsg = sqlite3_mprintf("invalid VTABLE_POOL_SIZE or "
+                                "VTABLE_MAX_POOL_SIZE, expected a number of "
+                                "frames");
+    return SQLITE_ERROR;
+  }
   // to check whether file exist or not
   struct stat buffer;
   bool is_file_exist = (stat(file_name.c_str(), &buffer) == 0);
-  // BufferPoolManager is a global object share by all the virtual tables
-  BufferPoolManager *buffer_pool_manager = new BufferPoolManager(10, file_name);
-  SQLITE_EXTENSION_INIT2(pApi);
+  const char *env_direct_io = getenv("VTABLE_DIRECT_IO");
+  DiskIOMode io_mode =
+      env_direct_io != nullptr && strcmp(env_direct_io, "1") == 0
+          ? DISK_IO_DIRECT
+          : DISK_IO_BUFFERED;
+  const char *env_compression = getenv("VTABLE_COMPRESSION");
+  DiskCompression compression =
+      env_compression != nullptr && strcmp(env_compression, "1") == 0
+          ? DISK_COMPRESSION_LZ
+          : DISK_COMPRESSION_NONE;
+  // BufferPoolManager is a global object share by all the virtual tables,
+  // LRU-K keeps index pages resident across sequential table scans
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(pool_size, file_name, 1, REPLACER_TYPE_LRU_K,
+                            max_pool_size, NUMA_MODE_OFF, io_mode,
+                            compression);
   // create header page from BufferPoolManager if necessary
   page_id_t header_page_id;
   HeaderPage *header_page;
@@ -324,13 +378,115 @@ __declspec(dllexport)
 
   (void)header_page;
   buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true);
+  const char *env_warm_up_file = getenv("VTABLE_WARMUP_FILE");
+  std::string warm_up_file = env_warm_up_file != nullptr
+                                 ? env_warm_up_file
+                                 : file_name + ".warmup";
+  if (!warm_up_file.empty()) {
+    if (is_file_exist)
+      buffer_pool_manager->LoadWarmUpFile(warm_up_file);
+    buffer_pool_manager->SetWarmUpFile(warm_up_file);
+  }
+  const char *env_page_heat = getenv("VTABLE_PAGE_HEAT");
+  if (env_page_heat != nullptr && strcmp(env_page_heat, "1") == 0)
+    buffer_pool_manager->SetPageHeatTracking(true);
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule,
                                  (void *)buffer_pool_manager);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_function(db, "vtable_pool_size", 0, SQLITE_UTF8,
+                                 buffer_pool_manager, PoolSizeFunction, 0, 0);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_function(db, "vtable_pool_size", 1, SQLITE_UTF8,
+                                 buffer_pool_manager, PoolSizeFunction, 0, 0);
+  if (rc == SQLITE_OK)
+    rc = RegisterBufferPoolStatsTables(db, buffer_pool_manager);
 
   return rc;
 }
 
+/*
+ * Parse a positive number of frames, a missing value keeps frame_count
+ */
+bool ParseFrameCount(const char *value, size_t &frame_count) {
+  if (value == nullptr)
+    return true;
+  char *end;
+  long long parsed = strtoll(value, &end, 10);
+  if (end == value || *end != '\0' || parsed <= 0)
+    return false;
+  frame_count = parsed;
+  return true;
+}
+
+/*
+ * Options are unquoted key=value arguments, the index definition is quoted
+ */
+bool IsModuleOption(const char *argument) {
+  return argument[0] != '\'' && strchr(argument, '=') != nullptr;
+}
+
+const char *FindIndexArgument(int argc, const char *const *argv) {
+  for (int i = 4; i < argc; i++) {
+    if (!IsModuleOption(argv[i]))
+      return argv[i];
+  }
+  return nullptr;
+}
+
+/*
+ * Apply the key=value module arguments, on error set pzErr and return false
+ */
+bool ApplyModuleOptions(BufferPoolManager *buffer_pool_manager, int argc,
+                        const char *const *argv, char **pzErr) {
+  for (int i = 4; i < argc; i++) {
+    if (!IsModuleOption(argv[i]))
+      continue;
+    std::string option(argv[i]);
+    std::string::size_type n = option.find('=');
+    std::string key = option.substr(0, n);
+    std::string value = option.substr(n + 1);
+    StringUtility::Trim(key);
+    StringUtility::Trim(value);
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+    if (key != "pool_size") {
+      *pzErr = sqlite3_mprintf("unknown vtable option %s", key.c_str());
+      return false;
+    }
+    size_t pool_size = 0;
+    if (!ParseFrameCount(value.c_str(), pool_size) ||
+        !buffer_pool_manager->ResizePool(pool_size)) {
+      *pzErr = sqlite3_mprintf("cannot resize the buffer pool to %s frames",
+                               value.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * SQL function vtable_pool_size([frames]), works like a pragma: resize the
+ * buffer pool if the number of frames is given, return the pool size
+ */
+void PoolSizeFunction(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+  BufferPoolManager *buffer_pool_manager =
+      reinterpret_cast<BufferPoolManager *>(sqlite3_user_data(ctx));
+  if (argc == 1) {
+    sqlite3_int64 pool_size = sqlite3_value_int64(argv[0]);
+    if (pool_size <= 0 || !buffer_pool_manager->ResizePool(pool_size)) {
+      std::string message =
+          "cannot resize the buffer pool to " + std::to_string(pool_size) +
+          " frames, budget is " +
+          std::to_string(buffer_pool_manager->GetMaxPoolSize()) +
+          " frames and pages in the frames to drop must be unpinned";
+      sqlite3_result_error(ctx, message.c_str(), -1);
+      return;
+    }
+  }
+  sqlite3_result_int64(ctx, buffer_pool_manager->GetPoolSize());
+}
+
 /* Helpers */
 Schema *ParseCreateStatement(const std::string &sql_base) {
   std::string::size_type n;
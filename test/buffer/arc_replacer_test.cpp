@@ -0,0 +1,154 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/testing_replacer_util.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ARCReplacerTest, SampleTest) {
+  // frame i holds page 100 + i unless changed
+  std::vector<page_id_t> frame_page;
+  for (int i = 0; i < 4; ++i)
+    frame_page.push_back(100 + i);
+  ARCReplacer<int> arc_replacer(
+      4, [&frame_page](const int &frame) { return frame_page[frame]; });
+
+  // frames 0..3 seen once, frame 0 and 1 seen again (pin and unpin)
+  for (int i = 0; i < 4; ++i)
+    arc_replacer.Insert(i);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(true, arc_replacer.Erase(i));
+    arc_replacer.Insert(i);
+  }
+  EXPECT_EQ(4U, arc_replacer.Size());
+  ARCStatistics stats = arc_replacer.GetStatistics();
+  EXPECT_EQ(2U, stats.t1_size);
+  EXPECT_EQ(2U, stats.t2_size);
+  EXPECT_EQ(0U, stats.target_t1_size);
+
+  // T1 is above its target size of 0, evict its least recent frame
+  int value;
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+  stats = arc_replacer.GetStatistics();
+  EXPECT_EQ(1U, stats.b1_size);
+
+  // page 102 comes back into frame 2: ghost hit in B1 grows T1's target
+  arc_replacer.Insert(2);
+  stats = arc_replacer.GetStatistics();
+  EXPECT_EQ(1U, stats.target_t1_size);
+  EXPECT_EQ(1U, stats.b1_ghost_hits);
+  EXPECT_EQ(0U, stats.b1_size);
+  EXPECT_EQ(3U, stats.t2_size);
+
+  // T1 (frame 3) is at its target size, evict from T2 instead
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_EQ(0, value);
+  stats = arc_replacer.GetStatistics();
+  EXPECT_EQ(1U, stats.b2_size);
+
+  // page 100 reloaded into frame 0: ghost hit in B2 shrinks T1's target
+  arc_replacer.Insert(0);
+  stats = arc_replacer.GetStatistics();
+  EXPECT_EQ(0U, stats.target_t1_size);
+  EXPECT_EQ(1U, stats.b2_ghost_hits);
+
+  // pinned frames are never victims
+  EXPECT_EQ(true, arc_replacer.Erase(3));
+  EXPECT_EQ(false, arc_replacer.Erase(3));
+  EXPECT_EQ(3U, arc_replacer.Size());
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_NE(3, value);
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_NE(3, value);
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  EXPECT_NE(3, value);
+  EXPECT_EQ(false, arc_replacer.Victim(value));
+}
+
+// replay trace through a fresh ARC replacer and return its final state
+static ARCStatistics ReplayARC(int num_frames, const std::vector<int> &trace) {
+  std::vector<int> frame_page;
+  ARCReplacer<int> arc(num_frames, [&frame_page](const int &frame) {
+    return frame_page[frame];
+  });
+  ReplayTrace(arc, num_frames, trace, &frame_page);
+  return arc.GetStatistics();
+}
+
+TEST(ARCReplacerTest, AdaptationTest) {
+  const int num_frames = 32;
+
+  // OLTP phase: point lookups over a hot set that fits the pool
+  std::vector<int> trace = ZipfianTrace(24, 20000);
+  ARCStatistics oltp = ReplayARC(num_frames, trace);
+
+  // scan phase: a 20 page loop that keeps missing in the small T1 and hits in
+  // B1, ARC grows T1
+  for (int round = 0; round < 50; ++round) {
+    for (int page = 0; page < 20; ++page)
+      trace.push_back(1000 + page);
+  }
+  ARCStatistics scan = ReplayARC(num_frames, trace);
+  EXPECT_GT(scan.b1_ghost_hits, oltp.b1_ghost_hits);
+  EXPECT_GT(scan.target_t1_size, oltp.target_t1_size);
+
+  // back to OLTP: the hot pages come back from B2 and T1 shrinks again
+  std::vector<int> lookups = ZipfianTrace(24, 20000, 0.99, 1);
+  trace.insert(trace.end(), lookups.begin(), lookups.end());
+  ARCStatistics back = ReplayARC(num_frames, trace);
+  EXPECT_GT(back.b2_ghost_hits, scan.b2_ghost_hits);
+  EXPECT_LT(back.target_t1_size, scan.target_t1_size);
+}
+
+TEST(ARCReplacerTest, ScanResistanceTest) {
+  const int num_frames = 64;
+  std::vector<int> frame_page;
+  ARCReplacer<int> arc(num_frames, [&frame_page](const int &frame) {
+    return frame_page[frame];
+  });
+  LRUReplacer<int> lru;
+  std::vector<int> trace = ScanTrace(96, 20000, 500, 128);
+  ReplayResult arc_result = ReplayTrace(arc, num_frames, trace, &frame_page);
+  ReplayResult lru_result = ReplayTrace(lru, num_frames, trace);
+  EXPECT_GT(arc_result.HitRate(), lru_result.HitRate());
+}
+
+TEST(ARCReplacerTest, EvictionOrderTest) {
+  std::vector<page_id_t> frame_page;
+  for (int i = 0; i < 8; ++i)
+    frame_page.push_back(100 + i);
+  ARCReplacer<int> arc_replacer(
+      8, [&frame_page](const int &frame) { return frame_page[frame]; });
+  for (int i = 0; i < 6; ++i)
+    arc_replacer.Insert(i);
+  // frames 1 and 4 move to T2, frame 3 is pinned
+  for (int i : {1, 4, 3}) {
+    EXPECT_EQ(true, arc_replacer.Erase(i));
+    if (i != 3)
+      arc_replacer.Insert(i);
+  }
+  // a ghost hit in B1 moves T1's target
+  int value;
+  EXPECT_EQ(true, arc_replacer.Victim(value));
+  arc_replacer.Insert(value);
+
+  // the order is what Victim would return, and it changes nothing
+  std::vector<int> order = arc_replacer.GetEvictionOrder();
+  EXPECT_EQ(5U, order.size());
+  EXPECT_EQ(5U, arc_replacer.Size());
+  for (int expected : order) {
+    EXPECT_EQ(true, arc_replacer.Victim(value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_EQ(true, arc_replacer.GetEvictionOrder().empty());
+}
+
+} // namespace cmudb
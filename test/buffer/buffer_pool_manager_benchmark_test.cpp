@@ -0,0 +1,367 @@
+/**
+ * buffer_pool_manager_benchmark_test.cpp
+ *
+ * Throughput numbers for the buffer pool, printed to stdout. The workloads are
+ * kept small so the benchmarks can run as part of "make check".
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <numeric>
+#include <random>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/numa_topology.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// total number of FetchPage/UnpinPage pairs issued per measurement
+static const int kBenchmarkOps = 200000;
+
+/*
+ * Run kBenchmarkOps point lookups spread over num_threads threads against
+ * pages [0, num_pages) and return the throughput in operations per second
+ */
+static double RunPointLookups(BufferPoolManager &bpm, int num_threads,
+                              int num_pages) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, num_threads, num_pages, &bpm]() {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (int i = 0; i < kBenchmarkOps / num_threads; ++i) {
+        page_id_t page_id = dist(rng);
+        if (bpm.FetchPage(page_id) != nullptr)
+          bpm.UnpinPage(page_id, false);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return kBenchmarkOps / elapsed.count();
+}
+
+TEST(BufferPoolManagerBenchmark, PartitionedPointLookup) {
+  const int pool_size = 256;
+  // every page stays resident, this measures latch contention only
+  const int num_pages = 128;
+  const size_t instance_counts[] = {1, 16};
+
+  printf("%-10s %-10s %15s\n", "threads", "instances", "ops/sec");
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    for (size_t num_instances : instance_counts) {
+      BufferPoolManager bpm(pool_size, "bench.db", num_instances);
+      page_id_t page_id;
+      for (int i = 0; i < num_pages; ++i) {
+        ASSERT_NE(nullptr, bpm.NewPage(page_id));
+        bpm.UnpinPage(page_id, false);
+      }
+      double ops = RunPointLookups(bpm, num_threads, num_pages);
+      printf("%-10d %-10zu %15.0f\n", num_threads, num_instances, ops);
+    }
+  }
+  remove("bench.db");
+}
+
+TEST(BufferPoolManagerBenchmark, HitOnlyFetch) {
+  // a single instance: hits never take its latch, only the atomic pin count
+  // and the lock-free page table are shared between threads
+  const int num_pages = 128;
+  BufferPoolManager bpm(num_pages, "bench.db");
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    bpm.UnpinPage(page_id, false);
+  }
+
+  printf("%-10s %15s %15s\n", "threads", "ops/sec", "ops/sec/thread");
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    double ops = RunPointLookups(bpm, num_threads, num_pages);
+    printf("%-10d %15.0f %15.0f\n", num_threads, ops, ops / num_threads);
+  }
+  remove("bench.db");
+}
+
+/*
+ * Mark pages [0, num_pages), all resident, dirty again
+ */
+static void DirtyAllPages(BufferPoolManager &bpm, int num_pages) {
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    char *data = bpm.FetchPage(page_id)->GetData();
+    data[0]++;
+    bpm.UnpinPage(page_id, true);
+  }
+}
+
+TEST(BufferPoolManagerBenchmark, FlushAllPages) {
+  printf("%-10s %15s %15s\n", "pages", "per page (ms)", "batched (ms)");
+  for (int num_pages = 1024; num_pages <= 8192; num_pages *= 2) {
+    BufferPoolManager bpm(num_pages, "bench.db", 4);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      ASSERT_NE(nullptr, bpm.NewPage(page_id));
+      bpm.UnpinPage(page_id, true);
+    }
+    // the file is allocated by now, both runs overwrite it
+    bpm.FlushAllPages();
+
+    // one write per page in no particular order, as frames hold them
+    std::vector<page_id_t> order(num_pages);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(0));
+    DirtyAllPages(bpm, num_pages);
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t page_id : order)
+      bpm.FlushPage(page_id);
+    // nothing dirty is left, this only syncs the file
+    bpm.FlushAllPages();
+    std::chrono::duration<double, std::milli> per_page =
+        std::chrono::steady_clock::now() - start;
+
+    DirtyAllPages(bpm, num_pages);
+    start = std::chrono::steady_clock::now();
+    bpm.FlushAllPages();
+    std::chrono::duration<double, std::milli> batched =
+        std::chrono::steady_clock::now() - start;
+    printf("%-10d %15.1f %15.1f\n", num_pages, per_page.count(),
+           batched.count());
+  }
+  remove("bench.db");
+}
+
+TEST(BufferPoolManagerBenchmark, NumaPlacement) {
+  // threads of every (emulated) node create pages and then keep working on
+  // them, as a session does with its temporary tables. Instance i is on node
+  // i % NUMA_EMULATED_NODES either way, without NUMA the page ids just do not
+  // care about it
+  const size_t num_instances = 8;
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  const int fetches_per_thread = 20000;
+
+  printf("%-10s %15s %15s\n", "mode", "remote (%)", "ops/sec");
+  for (NumaMode mode : {NUMA_MODE_OFF, NUMA_MODE_EMULATE}) {
+    BufferPoolManager bpm(1024, "bench.db", num_instances, REPLACER_TYPE_LRU,
+                          0, mode);
+    std::atomic<uint64_t> remote{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([&bpm, &remote, tid] {
+        int node = tid % NUMA_EMULATED_NODES;
+        NumaTopology::SetThreadNode(node);
+        std::vector<page_id_t> page_ids(pages_per_thread);
+        for (auto &page_id : page_ids) {
+          bpm.NewPage(page_id);
+          bpm.UnpinPage(page_id, true);
+        }
+        std::mt19937 rng(tid);
+        uint64_t thread_remote = 0;
+        for (int i = 0; i < fetches_per_thread; ++i) {
+          page_id_t page_id = page_ids[rng() % pages_per_thread];
+          if ((page_id % num_instances) % NUMA_EMULATED_NODES != (size_t)node)
+            thread_remote++;
+          if (bpm.FetchPage(page_id) != nullptr)
+            bpm.UnpinPage(page_id, false);
+        }
+        remote += thread_remote;
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    uint64_t total = (uint64_t)num_threads * fetches_per_thread;
+    printf("%-10s %15.1f %15.0f\n", mode == NUMA_MODE_OFF ? "off" : "emulate",
+           100.0 * remote / total, total / elapsed.count());
+  }
+  remove("bench.db");
+}
+
+TEST(BufferPoolManagerBenchmark, CompressedCache) {
+  // the same memory either as frames only, or half as frames and half as
+  // compressed page cache, for random fetches over a working set of 4 times
+  // the frames in the first case
+  const int memory_pages = 512;
+  const int num_pages = 2048;
+  const int num_fetches = 100000;
+
+  printf("%-10s %-10s %10s %12s %8s %12s\n", "frames", "cache (KB)",
+         "hits (%)", "disk reads", "ratio", "ops/sec");
+  for (bool use_cache : {false, true}) {
+    int frames = use_cache ? memory_pages / 2 : memory_pages;
+    BufferPoolManager bpm(frames, "bench.db");
+    bpm.SetCompressedCacheCapacity(use_cache ? memory_pages / 2 * PAGE_SIZE
+                                             : 0);
+    page_id_t page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      char *data = bpm.NewPage(page_id)->GetData();
+      // half filled with tuples
+      for (int offset = 0; offset + 64 <= PAGE_SIZE / 2; offset += 64)
+        snprintf(data + offset, 64, "%d|customer#%06d|%d.%02d",
+                 i * 100 + offset, i, offset * 7 % 1000, offset % 100);
+      bpm.UnpinPage(page_id, true);
+    }
+    bpm.ResetStatistics();
+
+    std::mt19937 rng(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_fetches; ++i) {
+      page_id = rng() % num_pages;
+      if (bpm.FetchPage(page_id) != nullptr)
+        bpm.UnpinPage(page_id, false);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    BufferPoolStatistics stats = bpm.GetStatistics();
+    CompressedCacheStatistics cache_stats = bpm.GetCompressedCacheStatistics();
+    uint64_t disk_reads = stats.misses - cache_stats.hits;
+    printf("%-10d %-10zu %10.1f %12lu %8.2f %12.0f\n", frames,
+           bpm.GetCompressedCacheCapacity() / 1024,
+           100.0 * (num_fetches - disk_reads) / num_fetches,
+           (unsigned long)disk_reads, cache_stats.GetCompressionRatio(),
+           num_fetches / elapsed.count());
+  }
+  remove("bench.db");
+}
+
+/*
+ * Number of pages of file_name held by the kernel page cache
+ */
+static size_t CountPageCachePages(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  off_t size = lseek(fd, 0, SEEK_END);
+  size_t num_pages = 0;
+  void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map != MAP_FAILED) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> resident((size + page_size - 1) / page_size);
+    if (mincore(map, size, resident.data()) == 0) {
+      for (unsigned char r : resident)
+        num_pages += r & 1;
+    }
+    munmap(map, size);
+  }
+  close(fd);
+  return num_pages * sysconf(_SC_PAGESIZE) / PAGE_SIZE;
+}
+
+TEST(BufferPoolManagerBenchmark, DirectIO) {
+  // random fetches over a file of 4 times the pool, starting with a cold
+  // page cache. Buffered, the kernel ends up caching most of the file on top
+  // of the pool, and serves the misses from there
+  const int pool_size = 1024;
+  const int num_pages = 4096;
+  const int num_fetches = 50000;
+  {
+    DiskManager disk_manager("bench.db");
+    std::vector<char> data(PAGE_SIZE, 'x');
+    for (int i = 0; i < num_pages; ++i)
+      disk_manager.WritePage(i, data.data());
+    disk_manager.Sync();
+  }
+
+  printf("%-10s %14s %16s %12s\n", "mode", "pool (KB)", "page cache (KB)",
+         "ops/sec");
+  for (DiskIOMode io_mode : {DISK_IO_BUFFERED, DISK_IO_DIRECT}) {
+    int fd = open("bench.db", O_RDONLY);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    BufferPoolManager bpm(pool_size, "bench.db", 1, REPLACER_TYPE_LRU, 0,
+                          NUMA_MODE_OFF, io_mode);
+    std::mt19937 rng(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_fetches; ++i) {
+      page_id_t page_id = rng() % num_pages;
+      if (bpm.FetchPage(page_id) != nullptr)
+        bpm.UnpinPage(page_id, false);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    printf("%-10s %14d %16zu %12.0f\n",
+           bpm.GetIOMode() == DISK_IO_DIRECT ? "direct" : "buffered",
+           pool_size * PAGE_SIZE / 1024,
+           CountPageCachePages("bench.db") * PAGE_SIZE / 1024,
+           num_fetches / elapsed.count());
+  }
+  remove("bench.db");
+}
+
+/*
+ * Fetch pages [0, num_pages) in order and add up their content, return the
+ * throughput in pages per second
+ */
+static double RunFullScan(BufferPoolManager &bpm, int num_pages,
+                          uint64_t &sum) {
+  auto start = std::chrono::steady_clock::now();
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    Page *page = bpm.FetchPage(page_id);
+    if (page == nullptr)
+      continue;
+    const uint64_t *words = reinterpret_cast<uint64_t *>(page->GetData());
+    sum = std::accumulate(words, words + PAGE_SIZE / sizeof(uint64_t), sum);
+    bpm.UnpinPage(page_id, false);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_pages / elapsed.count();
+}
+
+TEST(BufferPoolManagerBenchmark, Mmap) {
+  // a file of 8 times the pool with a warm page cache. Through the pool every
+  // miss copies a page out of the page cache and evicts another one, the
+  // mapping hands out the cached pages themselves
+  const int pool_size = 1024;
+  const int num_pages = 8192;
+  const int num_scans = 5;
+  {
+    DiskManager disk_manager("bench.db");
+    std::vector<char> data(PAGE_SIZE);
+    for (int i = 0; i < num_pages; ++i) {
+      memset(data.data(), i, PAGE_SIZE);
+      disk_manager.WritePage(i, data.data());
+    }
+  }
+
+  printf("%-10s %16s %16s %12s\n", "mode", "scan pages/sec",
+         "lookups/sec", "pool misses");
+  uint64_t expected_sum = 0;
+  for (DiskIOMode io_mode : {DISK_IO_BUFFERED, DISK_IO_MMAP}) {
+    BufferPoolManager bpm(pool_size, "bench.db", 4, REPLACER_TYPE_LRU, 0,
+                          NUMA_MODE_OFF, io_mode);
+    bpm.AdvisePages(0, num_pages, DISK_ADVICE_SEQUENTIAL);
+    uint64_t sum = 0;
+    // warm up the page cache
+    RunFullScan(bpm, num_pages, sum);
+    bpm.ResetStatistics();
+    double scan = 0;
+    for (int i = 0; i < num_scans; ++i) {
+      sum = 0;
+      scan += RunFullScan(bpm, num_pages, sum) / num_scans;
+    }
+    if (expected_sum == 0)
+      expected_sum = sum;
+    EXPECT_EQ(expected_sum, sum);
+    bpm.AdvisePages(0, num_pages, DISK_ADVICE_RANDOM);
+    double lookups = RunPointLookups(bpm, 4, num_pages);
+    printf("%-10s %16.0f %16.0f %12lu\n",
+           io_mode == DISK_IO_MMAP ? "mmap" : "buffered", scan, lookups,
+           bpm.GetStatistics().misses);
+  }
+  remove("bench.db");
+}
+
+} // namespace cmudb
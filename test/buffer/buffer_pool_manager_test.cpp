@@ -2,9 +2,17 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_ring.h"
+#include "common/exception.h"
+#include "disk/disk_manager.h"
 #include "gtest/gtest.h"
 
 namespace cmudb {
@@ -46,4 +54,655 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, MultipleInstancesTest) {
+  page_id_t temp_page_id;
+  // 4 instances with 3, 3, 2 and 2 frames
+  BufferPoolManager bpm(10, "test.db", 4);
+  EXPECT_EQ(4U, bpm.GetNumInstances());
+
+  // page i lands in instance i % 4
+  for (int i = 0; i < 12; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    sprintf(page->GetData(), "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+
+  // pin both frames of instance 2
+  EXPECT_NE(nullptr, bpm.FetchPage(2));
+  EXPECT_NE(nullptr, bpm.FetchPage(6));
+  // other instances still have unpinned frames, but page 10 can only live in
+  // instance 2
+  EXPECT_EQ(nullptr, bpm.FetchPage(10));
+  EXPECT_NE(nullptr, bpm.FetchPage(1));
+  EXPECT_EQ(true, bpm.UnpinPage(1, false));
+
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+  auto page = bpm.FetchPage(10);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 10"));
+  EXPECT_EQ(true, bpm.UnpinPage(10, false));
+  EXPECT_EQ(true, bpm.UnpinPage(6, false));
+
+  // every page survives eviction from its own instance
+  for (int i = 0; i < 12; ++i) {
+    char expected[PAGE_SIZE];
+    sprintf(expected, "page %d", i);
+    page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ClockReplacerTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(4, "test.db", 1, REPLACER_TYPE_CLOCK);
+  EXPECT_EQ(REPLACER_TYPE_CLOCK, bpm.GetReplacerType());
+
+  for (int i = 0; i < 4; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "page %d", i);
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  // cycle more pages than frames through the pool
+  for (int i = 4; i < 8; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  // dirty pages were written back on eviction
+  for (int i = 0; i < 4; ++i) {
+    char expected[PAGE_SIZE];
+    sprintf(expected, "page %d", i);
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ARCReplacerTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(4, "test.db", 1, REPLACER_TYPE_ARC);
+
+  for (int i = 0; i < 4; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // pages 0 and 1 are used twice and move to T2
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  // pages 4 and 5 push pages 2 and 3 out of T1 into B1
+  for (int i = 4; i < 6; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  ARCStatistics stats = bpm.GetARCStatistics();
+  EXPECT_EQ(2U, stats.t1_size);
+  EXPECT_EQ(2U, stats.t2_size);
+  EXPECT_EQ(2U, stats.b1_size);
+  EXPECT_EQ(0U, stats.b1_ghost_hits);
+
+  // reloading page 2 is a ghost hit, T1 should have been larger
+  auto page = bpm.FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 2"));
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+  stats = bpm.GetARCStatistics();
+  EXPECT_EQ(1U, stats.b1_ghost_hits);
+  EXPECT_EQ(1U, stats.target_t1_size);
+  EXPECT_EQ(3U, stats.t2_size);
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(10, "test.db");
+  for (int i = 0; i < 10; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "page %d", i);
+  }
+  // pages 0..7 are dirty and evictable, 8 and 9 stay pinned
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+
+  // keep at least half of the pool clean, write up to 60% of it
+  bpm.StartBackgroundWriter(0.5, 0.6, 10);
+  DiskManager disk_manager("test.db");
+  char data[PAGE_SIZE];
+  bool written = false;
+  for (int retry = 0; retry < 200 && !written; ++retry) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    memset(data, 0, PAGE_SIZE);
+    disk_manager.ReadPage(5, data);
+    written = strcmp(data, "page 5") == 0;
+  }
+  bpm.StopBackgroundWriter();
+  // pages are written in page id order, 0..5 reach the high watermark
+  EXPECT_EQ(true, written);
+  memset(data, 0, PAGE_SIZE);
+  disk_manager.ReadPage(6, data);
+  EXPECT_NE(0, strcmp(data, "page 6"));
+
+  // the destructor stops a running writer before flushing
+  bpm.StartBackgroundWriter(0.1, 0.2);
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(10, "test.db");
+  // pages 0..9 are written to disk while 10..19 are created
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  bpm.PrefetchPages(0, 4);
+  // never written, nothing to read ahead
+  bpm.PrefetchPages(100, 2);
+  bpm.WaitForPrefetches();
+
+  // change pages 0..4 behind the buffer pool's back, the ones read ahead are
+  // served from memory
+  DiskManager disk_manager("test.db");
+  char data[PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    memset(data, 0, PAGE_SIZE);
+    sprintf(data, "changed %d", i);
+    disk_manager.WritePage(i, data);
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    sprintf(expected, i < 4 ? "page %d" : "changed %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // read-ahead does not pin, the whole pool can still be used
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, BufferRingTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(10, "test.db");
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // pages 0..7 are in use by other queries
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  {
+    // a scan of pages 8..19, the ring gets 2 frames of the 10 frame pool
+    BufferRing ring(&bpm);
+    char expected[PAGE_SIZE];
+    for (int i = 8; i < 20; ++i) {
+      auto page = bpm.FetchPage(i, &ring);
+      ASSERT_NE(nullptr, page);
+      sprintf(expected, "page %d", i);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+  }
+
+  // pages 0..7 were not evicted by the scan: change them on disk and the
+  // buffer pool still returns its own copies
+  DiskManager disk_manager("test.db");
+  char data[PAGE_SIZE];
+  memset(data, 0, PAGE_SIZE);
+  for (int i = 0; i < 8; ++i) {
+    disk_manager.WritePage(i, data);
+  }
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    sprintf(expected, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+  }
+
+  // the ring gave its frames back when it was destroyed
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  for (ReplacerType replacer_type :
+       {REPLACER_TYPE_LRU, REPLACER_TYPE_CLOCK, REPLACER_TYPE_LRU_K,
+        REPLACER_TYPE_ARC}) {
+    page_id_t temp_page_id;
+    // 2 instances of 5 frames, budget of 40 frames
+    BufferPoolManager bpm(10, "test.db", 2, replacer_type, 40);
+    EXPECT_EQ(10U, bpm.GetPoolSize());
+    EXPECT_EQ(40U, bpm.GetMaxPoolSize());
+    EXPECT_EQ(false, bpm.ResizePool(41));
+    EXPECT_EQ(false, bpm.ResizePool(1));
+
+    // grow and pin every frame
+    EXPECT_EQ(true, bpm.ResizePool(30));
+    EXPECT_EQ(30U, bpm.GetPoolSize());
+    for (int i = 0; i < 30; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      sprintf(page->GetData(), "page %d", i);
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+    // pinned frames cannot go away
+    EXPECT_EQ(false, bpm.ResizePool(10));
+    EXPECT_EQ(30U, bpm.GetPoolSize());
+    for (int i = 0; i < 30; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+
+    // dropped pages are written back and read again on demand
+    EXPECT_EQ(true, bpm.ResizePool(10));
+    EXPECT_EQ(10U, bpm.GetPoolSize());
+    char expected[PAGE_SIZE];
+    for (int i = 0; i < 30; ++i) {
+      auto page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      sprintf(expected, "page %d", i);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_NE(nullptr, bpm.FetchPage(i));
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+    // frames dropped before are taken into use again
+    EXPECT_EQ(true, bpm.ResizePool(12));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const int num_threads = 8;
+  const int num_pages = 64;
+  // 4 instances of 10 frames, more than the threads can pin at once
+  BufferPoolManager bpm(40, "test.db", 4);
+  page_id_t temp_page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = temp_page_id;
+    bpm.UnpinPage(temp_page_id, true);
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &bpm]() {
+      for (int i = 0; i < 1000; ++i) {
+        page_id_t page_id = (i * 7 + tid) % num_pages;
+        auto page = bpm.FetchPage(page_id);
+        // at most num_threads pages are pinned at any time
+        EXPECT_NE(nullptr, page);
+        if (page == nullptr)
+          continue;
+        EXPECT_EQ(page_id, *reinterpret_cast<int *>(page->GetData()));
+        bpm.UnpinPage(page_id, false);
+      }
+    }));
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ConcurrentMissTest) {
+  const int num_threads = 8;
+  const int num_pages = 64;
+  // one instance, misses of the same latch overlap their reads
+  BufferPoolManager bpm(16, "test.db");
+  page_id_t temp_page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<int *>(page->GetData()) = temp_page_id;
+    bpm.UnpinPage(temp_page_id, true);
+  }
+  bpm.FlushAllPages();
+
+  // all threads miss the same pages at the same time, every page is read
+  // into one frame only
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&bpm]() {
+      for (int i = 0; i < 500; ++i) {
+        page_id_t page_id = (i * 13) % num_pages;
+        auto page = bpm.FetchPage(page_id);
+        EXPECT_NE(nullptr, page);
+        if (page == nullptr)
+          continue;
+        EXPECT_EQ(page_id, *reinterpret_cast<int *>(page->GetData()));
+        bpm.UnpinPage(page_id, false);
+      }
+    }));
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  std::vector<page_id_t> resident = bpm.GetResidentPages();
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ(resident.end(), std::unique(resident.begin(), resident.end()));
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, StatisticsTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(3, "test.db");
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_TRUE(bpm.UnpinPage(temp_page_id, true));
+  }
+  // the free list is used up, page 0 is evicted and written back
+  ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_TRUE(bpm.UnpinPage(temp_page_id, false));
+  ASSERT_NE(nullptr, bpm.FetchPage(1));
+  EXPECT_TRUE(bpm.UnpinPage(1, false));
+  // page 2 makes room for page 0
+  ASSERT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_TRUE(bpm.UnpinPage(0, false));
+  EXPECT_TRUE(bpm.FlushPage(1));
+  EXPECT_TRUE(bpm.FlushPage(3));
+
+  BufferPoolStatistics stats = bpm.GetStatistics();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(2U, stats.evictions);
+  EXPECT_EQ(4U, stats.dirty_writebacks);
+  EXPECT_EQ(0U, stats.pin_waits);
+  EXPECT_EQ(2U, stats.free_list_empty);
+
+  // page heat is only counted while enabled
+  EXPECT_TRUE(bpm.GetPageHeat().empty());
+  bpm.SetPageHeatTracking(true);
+  for (page_id_t page_id : {1, 3, 1, 0, 1, 0}) {
+    ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+    EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+  auto heat = bpm.GetPageHeat();
+  ASSERT_EQ(3U, heat.size());
+  EXPECT_EQ(std::make_pair(1, uint64_t(3)), heat[0]);
+  EXPECT_EQ(std::make_pair(0, uint64_t(2)), heat[1]);
+  EXPECT_EQ(std::make_pair(3, uint64_t(1)), heat[2]);
+  EXPECT_EQ(2U, bpm.GetPageHeat(2).size());
+
+  bpm.ResetStatistics();
+  EXPECT_EQ(0U, bpm.GetStatistics().hits);
+  EXPECT_TRUE(bpm.GetPageHeat().empty());
+
+  // counts from all cores add up
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&bpm] {
+      for (int i = 0; i < 1000; ++i) {
+        if (bpm.FetchPage(1) != nullptr)
+          bpm.UnpinPage(1, false);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  stats = bpm.GetStatistics();
+  EXPECT_EQ(4000U, stats.hits);
+  EXPECT_EQ(0U, stats.misses);
+  EXPECT_EQ(4000U, bpm.GetPageHeat()[0].second);
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  page_id_t temp_page_id;
+  {
+    BufferPoolManager bpm(10, "test.db");
+    for (int i = 0; i < 30; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      sprintf(page->GetData(), "page %d", i);
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+    // pages 23..29 and then 5, 7, 9 are cached, 9 the most recently used
+    for (page_id_t page_id : {5, 7, 9}) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+    std::vector<page_id_t> resident = bpm.GetResidentPages();
+    ASSERT_EQ(10U, resident.size());
+    EXPECT_EQ(std::vector<page_id_t>({9, 7, 5, 29}),
+              std::vector<page_id_t>(resident.begin(), resident.begin() + 4));
+    // written when the pool is flushed on destruction
+    bpm.SetWarmUpFile("test.db.warmup");
+  }
+
+  // a smaller pool takes the hottest pages that fit
+  BufferPoolManager bpm(4, "test.db");
+  EXPECT_EQ(0U, bpm.LoadWarmUpFile("missing.warmup"));
+  EXPECT_EQ(4U, bpm.LoadWarmUpFile("test.db.warmup"));
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id : {29, 5, 7, 9}) {
+    auto page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(expected, "page %d", page_id);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  BufferPoolStatistics stats = bpm.GetStatistics();
+  EXPECT_EQ(4U, stats.hits);
+  EXPECT_EQ(0U, stats.misses);
+  // loading again finds no free frame
+  EXPECT_EQ(0U, bpm.LoadWarmUpFile("test.db.warmup"));
+
+  remove("test.db");
+  remove("test.db.warmup");
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(50, "test.db", 4);
+  for (int i = 0; i < 40; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  bpm.FlushAllPages();
+  EXPECT_EQ(40U, bpm.GetStatistics().dirty_writebacks);
+
+  // runs of dirty pages with gaps, spread over all instances
+  for (page_id_t page_id : {3, 4, 5, 6, 7, 20, 22, 23, 39}) {
+    auto page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    sprintf(page->GetData(), "changed %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  bpm.FlushAllPages();
+  EXPECT_EQ(49U, bpm.GetStatistics().dirty_writebacks);
+  // nothing is left to write
+  bpm.FlushAllPages();
+  EXPECT_EQ(49U, bpm.GetStatistics().dirty_writebacks);
+
+  DiskManager disk_manager("test.db");
+  char data[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < 40; ++page_id) {
+    disk_manager.ReadPage(page_id, data);
+    bool changed = (page_id >= 3 && page_id <= 7) || page_id == 20 ||
+                   page_id == 22 || page_id == 23 || page_id == 39;
+    sprintf(expected, changed ? "changed %d" : "page %d", page_id);
+    EXPECT_EQ(0, strcmp(data, expected));
+  }
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, MmapTest) {
+  page_id_t temp_page_id;
+  {
+    BufferPoolManager bpm(10, "test.db");
+    for (int i = 0; i < 20; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      sprintf(page->GetData(), "page %d", i);
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+  }
+
+  // more pages than frames, all of them are served from the mapping
+  BufferPoolManager bpm(2, "test.db", 1, REPLACER_TYPE_LRU, 0, NUMA_MODE_OFF,
+                        DISK_IO_MMAP);
+  EXPECT_EQ(DISK_IO_MMAP, bpm.GetIOMode());
+  std::vector<Page *> pages;
+  for (page_id_t page_id = 0; page_id < 20; ++page_id) {
+    auto page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id))
+                                             .c_str()));
+    pages.push_back(page);
+  }
+  // the same Page again
+  EXPECT_EQ(pages[5], bpm.FetchPage(5));
+  EXPECT_EQ(true, bpm.UnpinPage(5, false));
+  for (page_id_t page_id = 0; page_id < 20; ++page_id)
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  EXPECT_EQ(false, bpm.UnpinPage(5, false));
+  EXPECT_EQ(nullptr, bpm.FetchPage(20));
+  EXPECT_EQ(0U, bpm.GetStatistics().misses);
+  {
+    auto guard = bpm.FetchPageRead(3);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(0, strcmp(guard.GetPage()->GetData(), "page 3"));
+  }
+  EXPECT_EQ(false, bpm.UnpinPage(3, false));
+
+  // read-only
+  EXPECT_FALSE(bpm.FetchPageWrite(3).IsValid());
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(false, bpm.DeletePage(3));
+  bpm.PrefetchPages(0, 20);
+  bpm.FlushAllPages();
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ChecksumTest) {
+  page_id_t temp_page_id;
+  {
+    BufferPoolManager bpm(10, "test.db");
+    for (int i = 0; i < 3; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      sprintf(page->GetData(), "page %d", i);
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+  }
+  {
+    std::fstream file("test.db",
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(PAGE_SIZE + 1);
+    file.put('x');
+  }
+
+  BufferPoolManager bpm(2, "test.db");
+  EXPECT_THROW(bpm.FetchPage(1), PageCorruptionException);
+  // the frame was given back, the pool is still whole
+  auto page0 = bpm.FetchPage(0);
+  auto page2 = bpm.FetchPage(2);
+  ASSERT_NE(nullptr, page0);
+  ASSERT_NE(nullptr, page2);
+  EXPECT_EQ(0, strcmp(page2->GetData(), "page 2"));
+  bpm.UnpinPage(0, false);
+  bpm.UnpinPage(2, false);
+  EXPECT_THROW(bpm.FetchPageRead(1), PageCorruptionException);
+  // read-ahead drops the page
+  bpm.PrefetchPages(0, 3);
+  bpm.WaitForPrefetches();
+  EXPECT_THROW(bpm.FetchPage(1), PageCorruptionException);
+
+  BufferPoolManager mapped(2, "test.db", 1, REPLACER_TYPE_LRU, 0,
+                           NUMA_MODE_OFF, DISK_IO_MMAP);
+  EXPECT_THROW(mapped.FetchPage(1), PageCorruptionException);
+  ASSERT_NE(nullptr, mapped.FetchPage(2));
+  mapped.UnpinPage(2, false);
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, CompressionTest) {
+  page_id_t temp_page_id;
+  {
+    // the pages are compressed as they are evicted and flushed
+    BufferPoolManager bpm(4, "test.db", 1, REPLACER_TYPE_LRU, 0,
+                          NUMA_MODE_OFF, DISK_IO_BUFFERED,
+                          DISK_COMPRESSION_LZ);
+    for (int i = 0; i < 20; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      sprintf(page->GetData(), "page %d", i);
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+    }
+  }
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_AUTO, DISK_IO_BUFFERED,
+                             DISK_COMPRESSION_LZ);
+    EXPECT_EQ(20, disk_manager.GetNumPages());
+    EXPECT_EQ(20 * COMPRESSED_SLOT_SIZE, disk_manager.GetStoredSize());
+  }
+
+  // every miss reads and decompresses a page, read ahead or not
+  BufferPoolManager bpm(2, "test.db", 1, REPLACER_TYPE_LRU, 0, NUMA_MODE_OFF,
+                        DISK_IO_BUFFERED, DISK_COMPRESSION_LZ);
+  bpm.PrefetchPages(0, 2);
+  bpm.WaitForPrefetches();
+  for (page_id_t page_id = 0; page_id < 20; ++page_id) {
+    auto page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id))
+                                             .c_str()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(18U, bpm.GetStatistics().misses);
+
+  remove("test.db");
+  remove("test.db.loc");
+}
+
 } // namespace cmudb
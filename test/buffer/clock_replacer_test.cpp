@@ -0,0 +1,75 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer(7);
+
+  // push element into replacer
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6U, clock_replacer.Size());
+
+  // the first sweep clears every reference bit, then frames go in slot order
+  int value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+
+  // a referenced frame gets a second chance
+  clock_replacer.Insert(3);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  EXPECT_EQ(2U, clock_replacer.Size());
+
+  // pop element from replacer after removal
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0U, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, EvictionOrderTest) {
+  ClockReplacer<int> clock_replacer(7);
+  for (int i = 1; i <= 6; ++i)
+    clock_replacer.Insert(i);
+  // move the hand, clearing reference bits on the way, then set some again
+  int value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  clock_replacer.Insert(value);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(2);
+  clock_replacer.Erase(3);
+
+  // the order is what Victim would return, and it changes nothing
+  std::vector<int> order = clock_replacer.GetEvictionOrder();
+  EXPECT_EQ(5U, order.size());
+  EXPECT_EQ(5U, clock_replacer.Size());
+  for (int expected : order) {
+    EXPECT_EQ(true, clock_replacer.Victim(value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_EQ(true, clock_replacer.GetEvictionOrder().empty());
+}
+
+} // namespace cmudb
@@ -0,0 +1,116 @@
+/**
+ * compressed_page_cache_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/compressed_page_cache.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+/*
+ * Fill data with text that compresses well
+ */
+static void FillPage(char *data, page_id_t page_id) {
+  memset(data, 0, PAGE_SIZE);
+  for (int offset = 0; offset + 64 <= PAGE_SIZE / 2; offset += 64)
+    snprintf(data + offset, 64, "page %d tuple %d", page_id, offset / 64);
+}
+
+TEST(CompressedPageCacheTest, SampleTest) {
+  char data[PAGE_SIZE];
+  char restored[PAGE_SIZE];
+  // disabled, nothing is kept
+  CompressedPageCache cache;
+  FillPage(data, 0);
+  cache.Insert(0, data);
+  EXPECT_FALSE(cache.Take(0, restored));
+  EXPECT_EQ(0U, cache.GetStatistics().inserts);
+
+  cache.SetCapacity(4 * PAGE_SIZE);
+  for (page_id_t page_id = 0; page_id < 10; ++page_id) {
+    FillPage(data, page_id);
+    cache.Insert(page_id, data);
+  }
+  CompressedCacheStatistics stats = cache.GetStatistics();
+  EXPECT_EQ(10U, stats.inserts);
+  EXPECT_EQ(10U, stats.num_pages);
+  EXPECT_LT(4.0, stats.GetCompressionRatio());
+
+  // a page is handed out once
+  EXPECT_TRUE(cache.Take(3, restored));
+  FillPage(data, 3);
+  EXPECT_EQ(0, memcmp(data, restored, PAGE_SIZE));
+  EXPECT_FALSE(cache.Take(3, restored));
+  cache.Erase(4);
+  EXPECT_FALSE(cache.Take(4, restored));
+  stats = cache.GetStatistics();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(2U, stats.misses);
+  EXPECT_EQ(8U, stats.num_pages);
+
+  // random data does not compress
+  std::mt19937 rng(0);
+  for (auto &byte : data)
+    byte = static_cast<char>(rng());
+  cache.Insert(20, data);
+  EXPECT_FALSE(cache.Take(20, restored));
+  EXPECT_EQ(1U, cache.GetStatistics().rejects);
+
+  // shrinking drops the least recently inserted pages
+  size_t page_size = stats.size / stats.num_pages;
+  cache.SetCapacity(page_size * 3);
+  stats = cache.GetStatistics();
+  EXPECT_GE(3U, stats.num_pages);
+  EXPECT_LE(2U, stats.num_pages);
+  EXPECT_TRUE(cache.Take(9, restored));
+  EXPECT_FALSE(cache.Take(0, restored));
+  cache.SetCapacity(0);
+  EXPECT_EQ(0U, cache.GetStatistics().num_pages);
+}
+
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(4, "test.db");
+  bpm.SetCompressedCacheCapacity(16 * PAGE_SIZE);
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    FillPage(page->GetData(), temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // the evicted pages were written back and compressed
+  EXPECT_EQ(16U, bpm.GetCompressedCacheStatistics().num_pages);
+
+  // served from the compressed cache even after the disk changed behind the
+  // buffer pool's back
+  DiskManager disk_manager("test.db");
+  char data[PAGE_SIZE] = {0};
+  for (page_id_t page_id = 0; page_id < 16; ++page_id)
+    disk_manager.WritePage(page_id, data);
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    auto page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    FillPage(expected, page_id);
+    EXPECT_EQ(0, memcmp(expected, page->GetData(), PAGE_SIZE));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  CompressedCacheStatistics stats = bpm.GetCompressedCacheStatistics();
+  EXPECT_EQ(8U, stats.hits);
+
+  // deleted pages are forgotten, the disk is read instead
+  EXPECT_TRUE(bpm.DeletePage(12));
+  auto page = bpm.FetchPage(12);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_EQ(true, bpm.UnpinPage(12, false));
+
+  remove("test.db");
+}
+
+} // namespace cmudb
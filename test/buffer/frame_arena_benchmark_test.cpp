@@ -0,0 +1,101 @@
+/**
+ * frame_arena_benchmark_test.cpp
+ *
+ * Random access to the frames of a regular and of a huge page backed arena,
+ * printed to stdout: throughput and, where perf events are available, data
+ * TLB load misses.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// 256MB of frames, far more than the TLB covers with 4KB pages
+static const size_t kArenaFrames = 65536;
+static const int kAccesses = 4000000;
+
+/*
+ * Open a counter of data TLB load misses of this thread, -1 if the kernel
+ * does not allow it
+ */
+static int OpenTLBMissCounter() {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static const char *PageTypeName(ArenaPageType page_type) {
+  switch (page_type) {
+  case ARENA_PAGE_TRANSPARENT_HUGE:
+    return "thp";
+  case ARENA_PAGE_HUGETLB_2MB:
+    return "hugetlb-2MB";
+  case ARENA_PAGE_HUGETLB_1GB:
+    return "hugetlb-1GB";
+  case ARENA_PAGE_REGULAR:
+  default:
+    return "4KB";
+  }
+}
+
+TEST(FrameArenaBenchmark, RandomFrameAccess) {
+  printf("%-12s %15s %15s\n", "pages", "accesses/sec", "dTLB misses");
+  for (bool use_huge_pages : {false, true}) {
+    FrameArena arena(kArenaFrames, use_huge_pages);
+    // fault everything in first, only steady state accesses are measured
+    for (size_t i = 0; i < kArenaFrames; ++i)
+      memset(arena.GetFrame(i), static_cast<int>(i), PAGE_SIZE);
+
+    // xorshift, cheap enough not to hide the cost of the memory access
+    uint64_t state = 88172645463325252ULL;
+    int counter = OpenTLBMissCounter();
+    if (counter >= 0) {
+      ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    auto start = std::chrono::steady_clock::now();
+    unsigned long sum = 0;
+    for (int i = 0; i < kAccesses; ++i) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      sum += arena.GetFrame(state % kArenaFrames)[(state >> 32) % PAGE_SIZE];
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    long long misses = -1;
+    if (counter >= 0) {
+      ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(counter, &misses, sizeof(misses)) != sizeof(misses))
+        misses = -1;
+      close(counter);
+    }
+
+    char misses_text[32] = "n/a";
+    if (misses >= 0)
+      snprintf(misses_text, sizeof(misses_text), "%lld", misses);
+    printf("%-12s %15.0f %15s\n", PageTypeName(arena.GetPageType()),
+           kAccesses / elapsed.count(), misses_text);
+    EXPECT_NE(0UL, sum);
+  }
+}
+
+} // namespace cmudb
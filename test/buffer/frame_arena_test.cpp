@@ -0,0 +1,60 @@
+/**
+ * frame_arena_test.cpp
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(FrameArenaTest, SampleTest) {
+  for (bool use_huge_pages : {false, true}) {
+    FrameArena arena(600, use_huge_pages);
+    EXPECT_EQ(600U, arena.GetNumFrames());
+    if (!use_huge_pages) {
+      EXPECT_EQ(ARENA_PAGE_REGULAR, arena.GetPageType());
+    }
+
+    // frames are 4KB aligned, adjacent, and start out zeroed
+    for (size_t i = 0; i < arena.GetNumFrames(); ++i) {
+      char *frame = arena.GetFrame(i);
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(frame) % 4096);
+      EXPECT_EQ(0, frame[0]);
+      memset(frame, 'a' + i % 26, PAGE_SIZE);
+    }
+    EXPECT_EQ(arena.GetFrame(1), arena.GetFrame(0) + PAGE_SIZE);
+    EXPECT_EQ('a' + 599 % 26, arena.GetFrame(599)[PAGE_SIZE - 1]);
+
+    // released frames read as zeros again, the others keep their content
+    arena.Release(0, arena.GetNumFrames());
+    EXPECT_EQ(0, arena.GetFrame(0)[0]);
+    arena.Release(100, 1);
+    EXPECT_EQ(0, arena.GetFrame(100)[0]);
+  }
+}
+
+TEST(FrameArenaTest, BufferPoolTest) {
+  // page data comes from the arena
+  BufferPoolManager bpm(10, "test.db", 1, REPLACER_TYPE_LRU, 20);
+  page_id_t page_id;
+  auto page = bpm.NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page->GetData()) % 4096);
+  strcpy(page->GetData(), "Hello");
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+
+  // shrinking gives the memory back, growing again must not lose pages
+  EXPECT_EQ(true, bpm.ResizePool(1));
+  EXPECT_EQ(true, bpm.ResizePool(20));
+  page = bpm.FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,147 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/testing_replacer_util.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(7, 2);
+  EXPECT_EQ(2U, lru_k_replacer.GetK());
+
+  // push element into replacer, frame 1 is accessed twice
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Insert(1);
+  EXPECT_EQ(6U, lru_k_replacer.Size());
+
+  // frames with a single access go first, oldest first
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+
+  // frame 5 reaches two accesses after frame 1 did
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, lru_k_replacer.Erase(4));
+  EXPECT_EQ(true, lru_k_replacer.Erase(6));
+  EXPECT_EQ(2U, lru_k_replacer.Size());
+
+  // frame 1 has the oldest second-to-last access
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+
+  // history survives Erase, frame 6 is evicted after single access frame 2
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+}
+
+TEST(LRUKReplacerTest, PrefetchTest) {
+  LRUKReplacer<int> lru_k_replacer(4, 2);
+
+  // frame 2 is used twice, frame 1 is read ahead and then used once
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.InsertPrefetched(1);
+  lru_k_replacer.Insert(1);
+  // the read ahead is not an access, frame 1 has a single one
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  // unused read aheads queue up behind older single access frames
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.InsertPrefetched(1);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const int num_frames = 64;
+  // index lookups on 96 hot pages mixed with scans of 128 cold pages
+  std::vector<int> trace = ScanTrace(96, 20000, 500, 128);
+
+  LRUReplacer<int> lru;
+  LRUKReplacer<int> lru_k(num_frames);
+  ReplayResult lru_result = ReplayTrace(lru, num_frames, trace);
+  ReplayResult lru_k_result = ReplayTrace(lru_k, num_frames, trace);
+  EXPECT_GT(lru_k_result.HitRate(), lru_result.HitRate());
+}
+
+TEST(LRUKReplacerTest, TableScanReplayTest) {
+  // the 10 frame pool of the virtual table module: two point queries walk the
+  // same 8 B+ tree pages between chunks of a table scan that each read 10 new
+  // heap pages
+  const int num_frames = 10;
+  const int num_rounds = 20;
+  std::vector<int> trace;
+  int next_heap_page = 100;
+  for (int round = 0; round < num_rounds; ++round) {
+    for (int query = 0; query < 2; ++query) {
+      for (int page = 0; page < 8; ++page)
+        trace.push_back(page);
+    }
+    for (int page = 0; page < 10; ++page)
+      trace.push_back(next_heap_page++);
+  }
+
+  LRUReplacer<int> lru;
+  LRUKReplacer<int> lru_k(num_frames);
+  ReplayResult lru_result = ReplayTrace(lru, num_frames, trace);
+  ReplayResult lru_k_result = ReplayTrace(lru_k, num_frames, trace);
+  // every chunk of the scan flushes the index out of the LRU pool, only the
+  // second query of a round hits
+  EXPECT_EQ(8U * num_rounds, lru_result.hits);
+  // with LRU-K the index stays resident after the first query
+  EXPECT_EQ(16U * num_rounds - 8, lru_k_result.hits);
+}
+
+TEST(LRUKReplacerTest, EvictionOrderTest) {
+  LRUKReplacer<int> lru_k_replacer(7, 2);
+  for (int i = 1; i <= 6; ++i)
+    lru_k_replacer.Insert(i);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.InsertPrefetched(0);
+  lru_k_replacer.Erase(5);
+
+  // frames short of k accesses first, then by k-th most recent access
+  std::vector<int> order = lru_k_replacer.GetEvictionOrder();
+  EXPECT_EQ(6U, order.size());
+  EXPECT_EQ(6U, lru_k_replacer.Size());
+  EXPECT_EQ(1, order[order.size() - 2]);
+  EXPECT_EQ(4, order.back());
+  for (int expected : order) {
+    int value;
+    EXPECT_EQ(true, lru_k_replacer.Victim(value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_EQ(true, lru_k_replacer.GetEvictionOrder().empty());
+}
+
+} // namespace cmudb
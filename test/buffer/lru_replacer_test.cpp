@@ -3,6 +3,7 @@
  */
 
 #include <cstdio>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
@@ -43,4 +44,23 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(1, value);
 }
 
+TEST(LRUReplacerTest, EvictionOrderTest) {
+  LRUReplacer<int> lru_replacer;
+  for (int i = 1; i <= 5; ++i)
+    lru_replacer.Insert(i);
+  lru_replacer.Insert(2);
+  lru_replacer.Erase(4);
+
+  // the order is what Victim would return, and it changes nothing
+  std::vector<int> order = lru_replacer.GetEvictionOrder();
+  EXPECT_EQ(std::vector<int>({1, 3, 5, 2}), order);
+  EXPECT_EQ(4U, lru_replacer.Size());
+  for (int expected : order) {
+    int value;
+    EXPECT_EQ(true, lru_replacer.Victim(value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_EQ(true, lru_replacer.GetEvictionOrder().empty());
+}
+
 } // namespace cmudb
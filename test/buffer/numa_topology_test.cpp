@@ -0,0 +1,79 @@
+/**
+ * numa_topology_test.cpp
+ */
+
+#include <cstdio>
+#include <sys/mman.h>
+#include <thread>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/numa_topology.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(NumaTopologyTest, SampleTest) {
+  NumaTopology off(NUMA_MODE_OFF);
+  EXPECT_EQ(1U, off.GetNumNodes());
+  EXPECT_EQ(0U, off.GetCurrentNode());
+
+  NumaTopology emulated(NUMA_MODE_EMULATE);
+  EXPECT_EQ((size_t)NUMA_EMULATED_NODES, emulated.GetNumNodes());
+  EXPECT_GT(emulated.GetNumNodes(), emulated.GetCurrentNode());
+  // the override only holds for the calling thread
+  NumaTopology::SetThreadNode(1);
+  EXPECT_EQ(1U, emulated.GetCurrentNode());
+  std::thread([&emulated] {
+    EXPECT_EQ(sched_getcpu() % NUMA_EMULATED_NODES,
+              (int)emulated.GetCurrentNode());
+  }).join();
+  NumaTopology::SetThreadNode(-1);
+
+  // the machine has at least one node, and memory can be bound to node 0
+  NumaTopology system(NUMA_MODE_BIND);
+  EXPECT_LE(1U, system.GetNumNodes());
+  EXPECT_GT(system.GetNumNodes(), system.GetCurrentNode());
+  size_t size = 16 * PAGE_SIZE;
+  void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, memory);
+  EXPECT_TRUE(system.BindMemory(memory, size, 0));
+  // nothing is bound without NUMA, or for less than a page
+  EXPECT_FALSE(emulated.BindMemory(memory, size, 0));
+  EXPECT_FALSE(system.BindMemory(static_cast<char *>(memory) + 1, 100, 0));
+  munmap(memory, size);
+}
+
+TEST(NumaTopologyTest, BufferPoolTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(40, "test.db", 4, REPLACER_TYPE_LRU, 0,
+                        NUMA_MODE_EMULATE);
+  EXPECT_EQ(0U, bpm.GetNode(0));
+  EXPECT_EQ(1U, bpm.GetNode(1));
+  EXPECT_EQ(0U, bpm.GetNode(2));
+
+  // new pages land on the calling thread's node
+  NumaTopology::SetThreadNode(1);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(1U, bpm.GetNode(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  EXPECT_EQ(0U, bpm.GetStatistics().remote_accesses);
+  // the page ids skipped meanwhile go to node 0 first
+  NumaTopology::SetThreadNode(0);
+  ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(0, temp_page_id);
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  EXPECT_EQ(0U, bpm.GetStatistics().remote_accesses);
+
+  // fetching the pages of the other node counts as remote
+  ASSERT_NE(nullptr, bpm.FetchPage(1));
+  EXPECT_EQ(true, bpm.UnpinPage(1, false));
+  EXPECT_EQ(1U, bpm.GetStatistics().remote_accesses);
+  NumaTopology::SetThreadNode(-1);
+
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,123 @@
+/**
+ * page_guard_test.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_guard.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(PageGuardTest, SampleTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(10, "test.db");
+
+  {
+    auto guard = bpm.NewPageWrite(temp_page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(0, temp_page_id);
+    strcpy(guard.GetDataMut(), "Hello");
+  }
+  // every guard gives its pin back, far more pages than frames fit through
+  for (int i = 1; i < 100; ++i) {
+    auto guard = bpm.NewPageWrite(temp_page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(i, temp_page_id);
+  }
+  for (int round = 0; round < 3; ++round) {
+    for (page_id_t i = 0; i < 100; ++i) {
+      auto guard = bpm.FetchPageRead(i);
+      ASSERT_TRUE(guard.IsValid());
+    }
+  }
+
+  // page zero was evicted dirty and written back
+  {
+    auto guard = bpm.FetchPageRead(0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(0, strcmp(guard.GetData(), "Hello"));
+  }
+  // a write guard can be used for reading too
+  {
+    auto guard = bpm.FetchPageWrite(0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(0, strcmp(guard.As<char>(), "Hello"));
+  }
+  EXPECT_TRUE(bpm.DeletePage(0));
+
+  remove("test.db");
+}
+
+TEST(PageGuardTest, MoveTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(2, "test.db");
+  for (int i = 0; i < 3; ++i)
+    bpm.NewPageWrite(temp_page_id);
+
+  auto guard = bpm.FetchPageRead(0);
+  ASSERT_TRUE(guard.IsValid());
+  // moving transfers the pin instead of taking a second one
+  ReadPageGuard moved(std::move(guard));
+  EXPECT_FALSE(guard.IsValid());
+  ASSERT_TRUE(moved.IsValid());
+  {
+    auto other = bpm.FetchPageRead(1);
+    ASSERT_TRUE(other.IsValid());
+    // all frames are pinned
+    EXPECT_FALSE(bpm.FetchPageRead(2).IsValid());
+    // move assignment releases the page the target held
+    other = std::move(moved);
+    EXPECT_FALSE(moved.IsValid());
+    EXPECT_TRUE(bpm.FetchPageRead(2).IsValid());
+  }
+  // released explicitly and by the destructor, both frames are free again
+  auto first = bpm.FetchPageWrite(1);
+  first.Release();
+  EXPECT_FALSE(first.IsValid());
+  EXPECT_TRUE(bpm.FetchPageRead(2).IsValid());
+  EXPECT_TRUE(bpm.DeletePage(0));
+  EXPECT_TRUE(bpm.DeletePage(1));
+
+  remove("test.db");
+}
+
+TEST(PageGuardTest, LatchTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(10, "test.db");
+  bpm.NewPageWrite(temp_page_id);
+
+  // readers share the page
+  auto reader1 = bpm.FetchPageRead(temp_page_id);
+  auto reader2 = bpm.FetchPageRead(temp_page_id);
+  ASSERT_TRUE(reader1.IsValid() && reader2.IsValid());
+
+  std::atomic<bool> written{false};
+  std::thread writer([&] {
+    auto guard = bpm.FetchPageWrite(temp_page_id);
+    strcpy(guard.GetDataMut(), "written");
+    written = true;
+  });
+  // the writer waits for both readers
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(written);
+  reader1.Release();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(written);
+  reader2.Release();
+  writer.join();
+  EXPECT_TRUE(written);
+
+  auto guard = bpm.FetchPageRead(temp_page_id);
+  EXPECT_EQ(0, strcmp(guard.GetData(), "written"));
+
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,50 @@
+/**
+ * replacer_benchmark_test.cpp
+ *
+ * Hit rate and cost per access of the replacement policies on synthetic
+ * traces, printed to stdout.
+ */
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/testing_replacer_util.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+static const int kNumFrames = 64;
+
+static void PrintResult(const std::string &trace, const std::string &policy,
+                        const ReplayResult &result) {
+  printf("%-10s %-8s %10.4f %10.1f\n", trace.c_str(), policy.c_str(),
+         result.HitRate(), result.ns_per_op);
+}
+
+static void ComparePolicies(const std::string &name,
+                            const std::vector<int> &trace) {
+  LRUReplacer<int> lru;
+  PrintResult(name, "lru", ReplayTrace(lru, kNumFrames, trace));
+  ClockReplacer<int> clock(kNumFrames);
+  PrintResult(name, "clock", ReplayTrace(clock, kNumFrames, trace));
+  LRUKReplacer<int> lru_k(kNumFrames);
+  PrintResult(name, "lru-2", ReplayTrace(lru_k, kNumFrames, trace));
+  std::vector<int> frame_page;
+  ARCReplacer<int> arc(kNumFrames, [&frame_page](const int &frame) {
+    return frame_page[frame];
+  });
+  PrintResult(name, "arc", ReplayTrace(arc, kNumFrames, trace, &frame_page));
+}
+
+TEST(ReplacerBenchmark, ComparePolicies) {
+  printf("%-10s %-8s %10s %10s\n", "trace", "policy", "hit rate", "ns/op");
+  ComparePolicies("zipfian", ZipfianTrace(1024, 200000));
+  ComparePolicies("scan", ScanTrace(128, 100000, 1000, 256));
+}
+
+} // namespace cmudb
@@ -0,0 +1,51 @@
+/**
+ * crc32c_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/crc32c.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(CRC32CTest, KnownValuesTest) {
+  // check values of RFC 3720, appendix B.4
+  std::vector<char> data(32, 0);
+  EXPECT_EQ(0x8a9136aaU, CRC32C::Checksum(data.data(), data.size()));
+  memset(data.data(), 0xff, data.size());
+  EXPECT_EQ(0x62a8ab43U, CRC32C::Checksum(data.data(), data.size()));
+  for (int i = 0; i < 32; ++i)
+    data[i] = i;
+  EXPECT_EQ(0x46dd794eU, CRC32C::Checksum(data.data(), data.size()));
+  EXPECT_EQ(0xe3069283U, CRC32C::Checksum("123456789", 9));
+  EXPECT_EQ(0xe3069283U, CRC32C::ChecksumPortable("123456789", 9));
+  EXPECT_EQ(0U, CRC32C::Checksum(nullptr, 0));
+}
+
+TEST(CRC32CTest, ImplementationsAgreeTest) {
+  if (!CRC32C::IsHardwareAccelerated())
+    printf("no SSE4.2, the table implementation is checked against itself\n");
+  std::mt19937 rng(0);
+  std::vector<char> data(20000);
+  for (char &c : data)
+    c = static_cast<char>(rng());
+  // every length and offset around the stream blocks of the hardware version
+  for (size_t size : {0, 1, 7, 8, 9, 100, 4079, 4080, 4081, 4092, 4096, 8160,
+                      12345, 19990}) {
+    for (size_t offset = 0; offset < 8; ++offset) {
+      uint32_t expected =
+          CRC32C::ChecksumPortable(data.data() + offset, size);
+      EXPECT_EQ(expected, CRC32C::Checksum(data.data() + offset, size));
+      // in two pieces
+      size_t half = size / 3;
+      uint32_t crc = CRC32C::Checksum(data.data() + offset, half);
+      EXPECT_EQ(expected, CRC32C::Checksum(data.data() + offset + half,
+                                           size - half, crc));
+    }
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,95 @@
+/**
+ * lz_codec_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/lz_codec.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+/*
+ * Compress data, check the size bound, and decompress it again
+ */
+static size_t RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed(LZCodec::MaxCompressedSize(data.size()));
+  size_t size = LZCodec::Compress(data.data(), data.size(), compressed.data(),
+                                  compressed.size());
+  EXPECT_LT(0U, size);
+  std::vector<char> restored(data.size());
+  EXPECT_TRUE(LZCodec::Decompress(compressed.data(), size, restored.data(),
+                                  restored.size()));
+  EXPECT_EQ(data, restored);
+  return size;
+}
+
+TEST(LZCodecTest, SampleTest) {
+  // an empty page compresses to almost nothing
+  std::vector<char> page(PAGE_SIZE, 0);
+  EXPECT_GT(64U, RoundTrip(page));
+
+  // tuples with a repeated layout
+  for (size_t offset = 0; offset + 32 <= PAGE_SIZE; offset += 32)
+    snprintf(&page[offset], 32, "tuple %05zu|name %03zu|", offset / 32,
+             offset % 97);
+  EXPECT_GT(PAGE_SIZE / 2U, RoundTrip(page));
+
+  // random bytes do not compress, but still round-trip
+  std::mt19937 rng(0);
+  for (auto &byte : page)
+    byte = static_cast<char>(rng());
+  EXPECT_LE(PAGE_SIZE, RoundTrip(page));
+
+  // short periods, the matches overlap what they produce
+  for (size_t period : {1, 2, 3, 7, 300}) {
+    std::vector<char> data(5000);
+    for (size_t i = 0; i < data.size(); ++i)
+      data[i] = i < period ? static_cast<char>(rng()) : data[i - period];
+    RoundTrip(data);
+  }
+
+  // inputs around the minimum match and the length encodings
+  for (size_t size : {0, 1, 4, 11, 12, 13, 20, 270, 300, 70000}) {
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; ++i)
+      data[i] = i < size / 2 ? 'a' : static_cast<char>(rng() % 4);
+    RoundTrip(data);
+  }
+}
+
+TEST(LZCodecTest, ErrorTest) {
+  std::vector<char> page(PAGE_SIZE, 'x');
+  std::vector<char> compressed(LZCodec::MaxCompressedSize(PAGE_SIZE));
+  size_t size = LZCodec::Compress(page.data(), page.size(), compressed.data(),
+                                  compressed.size());
+  ASSERT_LT(0U, size);
+  // too small an output buffer
+  EXPECT_EQ(0U, LZCodec::Compress(page.data(), page.size(), compressed.data(),
+                                  size - 1));
+
+  std::vector<char> restored(PAGE_SIZE);
+  // truncated input, or a different expected size
+  EXPECT_FALSE(LZCodec::Decompress(compressed.data(), size - 1,
+                                   restored.data(), restored.size()));
+  EXPECT_FALSE(LZCodec::Decompress(compressed.data(), size, restored.data(),
+                                   restored.size() - 1));
+  // a match reaching before the start of the output
+  const char bad[] = {0x10, 'a', 0x05, 0x00, 0x00};
+  EXPECT_FALSE(
+      LZCodec::Decompress(bad, sizeof(bad), restored.data(), restored.size()));
+  // garbage never overruns the output
+  std::mt19937 rng(1);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<char> garbage(1 + rng() % 64);
+    for (auto &byte : garbage)
+      byte = static_cast<char>(rng());
+    LZCodec::Decompress(garbage.data(), garbage.size(), restored.data(), 16);
+  }
+}
+
+} // namespace cmudb
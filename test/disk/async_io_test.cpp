@@ -0,0 +1,107 @@
+/**
+ * async_io_test.cpp
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include "disk/async_io.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// write and read back pages with many requests in flight
+static void ReadWriteTest(AsyncIOBackend backend) {
+  const int num_pages = 256;
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  for (int i = 0; i < num_pages; ++i)
+    memset(&data[i * PAGE_SIZE], 'a' + i % 26, PAGE_SIZE);
+  {
+    DiskManager disk_manager("test.db", backend);
+    std::vector<std::future<bool>> writes;
+    // single pages for the first half, one vectored request for the rest
+    for (int i = 0; i < num_pages / 2; ++i)
+      writes.push_back(disk_manager.WritePageAsync(i, &data[i * PAGE_SIZE]));
+    std::vector<const char *> pages;
+    for (int i = num_pages / 2; i < num_pages; ++i)
+      pages.push_back(&data[i * PAGE_SIZE]);
+    writes.push_back(disk_manager.WritePagesAsync(num_pages / 2, pages.data(),
+                                                  pages.size()));
+    for (auto &write : writes)
+      EXPECT_TRUE(write.get());
+    EXPECT_EQ(num_pages, disk_manager.GetNumPages());
+
+    std::vector<char> buffer(num_pages * PAGE_SIZE, 'x');
+    std::atomic<int> num_done(0);
+    std::promise<void> all_done;
+    for (int i = 0; i < num_pages; ++i) {
+      disk_manager.ReadPageAsync(i, &buffer[i * PAGE_SIZE],
+                                 [&num_done, &all_done](bool ok) {
+                                   EXPECT_TRUE(ok);
+                                   if (++num_done == num_pages)
+                                     all_done.set_value();
+                                 });
+    }
+    all_done.get_future().wait();
+    for (int i = 0; i < num_pages; ++i)
+      EXPECT_EQ(0, memcmp(&data[i * PAGE_SIZE], &buffer[i * PAGE_SIZE],
+                          PAGE_DATA_SIZE));
+
+    // never written, reads as zeros
+    memset(buffer.data(), 'x', PAGE_SIZE);
+    EXPECT_TRUE(
+        disk_manager.ReadPageAsync(num_pages + 10, buffer.data()).get());
+    EXPECT_EQ(0, buffer[0]);
+    EXPECT_EQ(0, buffer[PAGE_SIZE - 1]);
+  }
+  // the synchronous calls see what the asynchronous ones wrote
+  DiskManager disk_manager("test.db");
+  char buffer[PAGE_SIZE];
+  disk_manager.ReadPage(num_pages - 1, buffer);
+  EXPECT_EQ(0, memcmp(&data[(num_pages - 1) * PAGE_SIZE], buffer,
+                      PAGE_DATA_SIZE));
+
+  remove("test.db");
+}
+
+TEST(AsyncIOTest, IOUringTest) {
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_URING);
+    if (disk_manager.GetAsyncIOBackend() != ASYNC_IO_URING) {
+      printf("io_uring not available, falls back to the thread pool\n");
+    }
+  }
+  ReadWriteTest(ASYNC_IO_URING);
+}
+
+TEST(AsyncIOTest, ThreadPoolTest) {
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_THREAD_POOL);
+    EXPECT_EQ(ASYNC_IO_THREAD_POOL, disk_manager.GetAsyncIOBackend());
+  }
+  ReadWriteTest(ASYNC_IO_THREAD_POOL);
+}
+
+TEST(AsyncIOTest, EngineTest) {
+  // a failed request reports -errno
+  for (AsyncIOBackend backend : {ASYNC_IO_AUTO, ASYNC_IO_THREAD_POOL}) {
+    AsyncIOEngine *engine = AsyncIOEngine::Create(backend);
+    char buffer[PAGE_SIZE];
+    std::promise<ssize_t> result;
+    AsyncIORequest *request = new AsyncIORequest();
+    request->op = ASYNC_IO_READ;
+    request->fd = -1;
+    request->offset = 0;
+    request->iov.push_back({buffer, PAGE_SIZE});
+    request->callback = [&result](ssize_t res) { result.set_value(res); };
+    engine->Submit(request);
+    EXPECT_EQ(-EBADF, result.get_future().get());
+    delete engine;
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,144 @@
+/**
+ * disk_manager_benchmark_test.cpp
+ *
+ * Cost of the disk manager's own work next to the cost of the I/O, printed
+ * to stdout. The workloads are kept small so the benchmarks can run as part
+ * of "make check".
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "common/crc32c.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+/*
+ * Microseconds per call of op, run num_ops times
+ */
+template <typename Op> static double TimePerOp(int num_ops, Op op) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; ++i)
+    op(i);
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / num_ops;
+}
+
+TEST(DiskManagerBenchmark, Checksum) {
+  // the page checksums against the page reads and writes they guard, once
+  // from the kernel page cache and once from the device
+  const int num_pages = 2048;
+  const int num_ops = 20000;
+  alignas(DIRECT_IO_ALIGNMENT) static char data[PAGE_SIZE];
+  std::mt19937 rng(0);
+  for (char &c : data)
+    c = static_cast<char>(rng());
+  volatile uint32_t sink = 0;
+  double hardware = TimePerOp(num_ops * 10, [&](int) {
+    sink = sink + CRC32C::Checksum(data, PAGE_DATA_SIZE);
+  });
+  double portable = TimePerOp(num_ops, [&](int) {
+    sink = sink + CRC32C::ChecksumPortable(data, PAGE_DATA_SIZE);
+  });
+  double checksum = CRC32C::IsHardwareAccelerated() ? hardware : portable;
+  printf("crc32c of a page: %.3f us (%s), portable %.3f us\n", checksum,
+         CRC32C::IsHardwareAccelerated() ? "sse4.2" : "portable", portable);
+
+  {
+    DiskManager disk_manager("bench.db");
+    for (int i = 0; i < num_pages; ++i)
+      disk_manager.WritePage(i, data);
+    disk_manager.Sync();
+  }
+  printf("%-16s %14s %14s\n", "operation", "us/page", "checksum (%)");
+  for (DiskIOMode io_mode : {DISK_IO_BUFFERED, DISK_IO_DIRECT}) {
+    DiskManager disk_manager("bench.db", ASYNC_IO_AUTO, io_mode);
+    if (disk_manager.GetIOMode() != io_mode)
+      continue;
+    const char *mode = io_mode == DISK_IO_DIRECT ? "direct" : "cached";
+    // reads are verified once, writes stamp a copy
+    double read = TimePerOp(num_ops, [&](int) {
+      disk_manager.ReadPage(rng() % num_pages, data);
+    });
+    double write = TimePerOp(num_ops, [&](int) {
+      disk_manager.WritePage(rng() % num_pages, data);
+    });
+    printf("read %-11s %14.2f %14.2f\n", mode, read, 100 * checksum / read);
+    printf("write %-10s %14.2f %14.2f\n", mode, write, 100 * checksum / write);
+  }
+  remove("bench.db");
+}
+
+TEST(DiskManagerBenchmark, Compression) {
+  // table pages half full of varchar tuples, stored as is and compressed:
+  // the size of the file, and the cost of the reads and writes from the
+  // kernel page cache and from the device
+  const int num_pages = 2048;
+  const int num_ops = 20000;
+  const char *words[] = {"alice", "bob", "carol", "pittsburgh", "seattle",
+                         "order", "shipped", "pending", "2017-09-01", "42"};
+  std::mt19937 rng(0);
+  std::vector<std::vector<char>> pages(num_pages,
+                                       std::vector<char>(PAGE_SIZE, 0));
+  for (std::vector<char> &page : pages) {
+    // tuples from the end of the page down to its middle
+    size_t offset = PAGE_SIZE / 2;
+    while (offset < PAGE_DATA_SIZE - 64) {
+      std::string tuple = std::to_string(rng() % 100000);
+      for (int i = 0; i < 4; ++i)
+        tuple += std::string("|") + words[rng() % 10];
+      memcpy(page.data() + offset, tuple.data(), tuple.size());
+      offset += tuple.size() + 1;
+    }
+    for (size_t i = 0; i < 16; ++i)
+      page[i] = static_cast<char>(rng());
+  }
+
+  printf("%-12s %10s %10s %10s %10s %10s %10s\n", "storage", "stored KB",
+         "disk KB", "read c us", "write c us", "read d us", "write d us");
+  for (DiskCompression compression :
+       {DISK_COMPRESSION_NONE, DISK_COMPRESSION_LZ}) {
+    size_t stored_size;
+    {
+      DiskManager disk_manager("bench.db", ASYNC_IO_AUTO, DISK_IO_BUFFERED,
+                               compression);
+      for (int i = 0; i < num_pages; ++i)
+        disk_manager.WritePage(i, pages[i].data());
+      disk_manager.Sync();
+      stored_size = disk_manager.GetStoredSize();
+    }
+    struct stat stat_buf;
+    stat("bench.db", &stat_buf);
+    double times[4] = {};
+    for (int i = 0; i < 2; ++i) {
+      DiskIOMode io_mode = i == 0 ? DISK_IO_BUFFERED : DISK_IO_DIRECT;
+      DiskManager disk_manager("bench.db", ASYNC_IO_AUTO, io_mode,
+                               compression);
+      alignas(DIRECT_IO_ALIGNMENT) static char data[PAGE_SIZE];
+      times[2 * i] = TimePerOp(num_ops, [&](int) {
+        disk_manager.ReadPage(rng() % num_pages, data);
+      });
+      // rewritten as they were, in place
+      times[2 * i + 1] = TimePerOp(num_ops, [&](int) {
+        page_id_t page_id = rng() % num_pages;
+        disk_manager.WritePage(page_id, pages[page_id].data());
+      });
+    }
+    printf("%-12s %10zu %10lu %10.2f %10.2f %10.2f %10.2f\n",
+           compression == DISK_COMPRESSION_LZ ? "compressed" : "as is",
+           stored_size / 1024, stat_buf.st_blocks * 512 / 1024, times[0],
+           times[1], times[2], times[3]);
+    remove("bench.db");
+    remove("bench.db.loc");
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,427 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "common/exception.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, SampleTest) {
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(0, disk_manager.GetNumPages());
+    // never written, reads as zeros
+    memset(buffer, 'x', PAGE_SIZE);
+    disk_manager.ReadPage(3, buffer);
+    EXPECT_EQ(0, buffer[0]);
+    EXPECT_EQ(0, buffer[PAGE_SIZE - 1]);
+
+    memset(data, 0, PAGE_SIZE);
+    strcpy(data, "page 5");
+    disk_manager.WritePage(5, data);
+    EXPECT_EQ(6, disk_manager.GetNumPages());
+    disk_manager.ReadPage(5, buffer);
+    EXPECT_EQ(0, memcmp(data, buffer, PAGE_DATA_SIZE));
+
+    const char *pages[] = {data, data};
+    disk_manager.WritePages(6, pages, 2);
+    disk_manager.Sync();
+    EXPECT_EQ(8, disk_manager.GetNumPages());
+  }
+  // reopened, the size comes from the file
+  DiskManager disk_manager("test.db");
+  EXPECT_EQ(8, disk_manager.GetNumPages());
+  std::vector<char> three_pages(3 * PAGE_SIZE, 'x');
+  disk_manager.ReadPages(6, 3, three_pages.data());
+  EXPECT_EQ(0, strcmp(three_pages.data() + PAGE_SIZE, "page 5"));
+  EXPECT_EQ(0, three_pages[2 * PAGE_SIZE]);
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, ConcurrentTest) {
+  DiskManager disk_manager("test.db");
+  const int num_threads = 8;
+  const int pages_per_thread = 50;
+  std::vector<std::thread> threads;
+  // no shared cursor, every thread reads back exactly what it wrote
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&disk_manager, tid] {
+      char data[PAGE_SIZE];
+      char buffer[PAGE_SIZE];
+      for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          page_id_t page_id = i * num_threads + tid;
+          memset(data, 'a' + (page_id + round) % 26, PAGE_SIZE);
+          disk_manager.WritePage(page_id, data);
+          disk_manager.ReadPage(page_id, buffer);
+          EXPECT_EQ(0, memcmp(data, buffer, PAGE_DATA_SIZE));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(num_threads * pages_per_thread, disk_manager.GetNumPages());
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  // one byte off an aligned address, copied through a bounce buffer
+  alignas(DIRECT_IO_ALIGNMENT) static char unaligned[3 * PAGE_SIZE + 1];
+  char *data = unaligned + 1;
+  char buffer[PAGE_SIZE];
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_AUTO, DISK_IO_DIRECT);
+    if (disk_manager.GetIOMode() != DISK_IO_DIRECT) {
+      printf("O_DIRECT not supported, falls back to buffered I/O\n");
+    }
+    memset(data, 'a', PAGE_SIZE);
+    disk_manager.WritePage(0, data);
+    memset(data + PAGE_SIZE, 'b', PAGE_SIZE);
+    memset(data + 2 * PAGE_SIZE, 'c', PAGE_SIZE);
+    const char *pages[] = {data + PAGE_SIZE, data + 2 * PAGE_SIZE};
+    disk_manager.WritePages(1, pages, 2);
+    EXPECT_TRUE(disk_manager.WritePageAsync(3, data).get());
+    EXPECT_EQ(4, disk_manager.GetNumPages());
+
+    memset(data, 0, 3 * PAGE_SIZE);
+    disk_manager.ReadPages(1, 2, data);
+    EXPECT_EQ('b', data[0]);
+    EXPECT_EQ('c', data[PAGE_SIZE + PAGE_DATA_SIZE - 1]);
+    EXPECT_TRUE(disk_manager.ReadPageAsync(3, data).get());
+    EXPECT_EQ('a', data[PAGE_DATA_SIZE - 1]);
+    // past the end of the file
+    disk_manager.ReadPage(5, data);
+    EXPECT_EQ(0, data[0]);
+  }
+  // the same content through the page cache
+  DiskManager disk_manager("test.db");
+  disk_manager.ReadPage(2, buffer);
+  EXPECT_EQ('c', buffer[0]);
+  EXPECT_EQ('c', buffer[PAGE_DATA_SIZE - 1]);
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, MmapTest) {
+  char data[PAGE_SIZE];
+  // nothing to map
+  EXPECT_THROW(DiskManager("test.db", ASYNC_IO_AUTO, DISK_IO_MMAP), Exception);
+  {
+    DiskManager disk_manager("test.db");
+    for (int i = 0; i < 3; ++i) {
+      memset(data, 'a' + i, PAGE_SIZE);
+      disk_manager.WritePage(i, data);
+    }
+  }
+
+  DiskManager disk_manager("test.db", ASYNC_IO_AUTO, DISK_IO_MMAP);
+  EXPECT_EQ(DISK_IO_MMAP, disk_manager.GetIOMode());
+  EXPECT_EQ(3u, disk_manager.GetNumMappedPages());
+  const char *page = disk_manager.GetMappedPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ('b', page[0]);
+  EXPECT_EQ('b', page[PAGE_DATA_SIZE - 1]);
+  EXPECT_EQ(nullptr, disk_manager.GetMappedPage(3));
+  EXPECT_EQ(nullptr, disk_manager.GetMappedPage(INVALID_PAGE_ID));
+  // hints past the end are cut off
+  disk_manager.AdvisePages(0, 10, DISK_ADVICE_SEQUENTIAL);
+  disk_manager.AdvisePages(2, 1, DISK_ADVICE_WILLNEED);
+  disk_manager.ReadPage(2, data);
+  EXPECT_EQ('c', data[0]);
+
+  // read-only
+  EXPECT_TRUE(disk_manager.IsAllocated(2));
+  EXPECT_THROW(disk_manager.WritePage(0, data), Exception);
+  EXPECT_THROW(disk_manager.AllocatePage(), Exception);
+  EXPECT_THROW(disk_manager.DeallocatePage(0), Exception);
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, FreeSpaceMapTest) {
+  {
+    DiskManager disk_manager("test.db");
+    for (int i = 0; i < 10; ++i)
+      EXPECT_EQ(i, disk_manager.AllocatePage());
+    disk_manager.DeallocatePage(3);
+    disk_manager.DeallocatePage(7);
+    // not allocated, ignored
+    disk_manager.DeallocatePage(7);
+    disk_manager.DeallocatePage(20);
+    EXPECT_EQ(2u, disk_manager.GetNumFreePages());
+    EXPECT_FALSE(disk_manager.IsAllocated(3));
+
+    // the lowest free page, or the nearest one from the hint on
+    EXPECT_EQ(7, disk_manager.AllocatePage(5));
+    EXPECT_EQ(3, disk_manager.AllocatePage(8));
+    EXPECT_EQ(10, disk_manager.AllocatePage());
+    EXPECT_EQ(0u, disk_manager.GetNumFreePages());
+    disk_manager.DeallocatePage(4);
+    disk_manager.Sync();
+  }
+  // the map survives a restart
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(1u, disk_manager.GetNumFreePages());
+    EXPECT_TRUE(disk_manager.IsAllocated(3));
+    EXPECT_FALSE(disk_manager.IsAllocated(4));
+    EXPECT_TRUE(disk_manager.IsAllocated(10));
+    EXPECT_EQ(4, disk_manager.AllocatePage());
+    EXPECT_EQ(11, disk_manager.AllocatePage());
+  }
+
+  // pages of several map pages, full map pages are skipped
+  {
+    DiskManager disk_manager("test.db");
+    while (disk_manager.AllocatePage() < 3 * FSM_PAGE_BITS) {
+    }
+    disk_manager.DeallocatePage(5);
+    disk_manager.DeallocatePage(2 * FSM_PAGE_BITS + 1);
+    // wraps around within the extent of the hint
+    EXPECT_EQ(2 * FSM_PAGE_BITS + 1,
+              disk_manager.AllocatePage(2 * FSM_PAGE_BITS + 2));
+    EXPECT_EQ(5, disk_manager.AllocatePage());
+    EXPECT_EQ(3 * FSM_PAGE_BITS + 1, disk_manager.AllocatePage());
+  }
+
+  remove("test.db");
+  remove("test.db.fsm");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  DiskManager disk_manager("test.db");
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i, disk_manager.AllocatePage());
+  // the extent of the hint is full, a new one is started
+  EXPECT_EQ(2 * EXTENT_PAGES, disk_manager.AllocatePage(10));
+  EXPECT_EQ(size_t(2 * EXTENT_PAGES - 100), disk_manager.GetNumFreePages());
+  // the pages skipped are handed out near hints in their extent
+  EXPECT_EQ(100, disk_manager.AllocatePage(EXTENT_PAGES + 6));
+  EXPECT_EQ(2 * EXTENT_PAGES + 1, disk_manager.AllocatePage(2 * EXTENT_PAGES));
+  EXPECT_EQ(101, disk_manager.AllocatePage());
+
+  // the new extent is preallocated, the file size is left alone
+  struct stat st;
+  ASSERT_EQ(0, stat("test.db", &st));
+  EXPECT_EQ(0, st.st_size);
+  EXPECT_GE(st.st_blocks * 512, 3 * EXTENT_PAGES * PAGE_SIZE);
+
+  remove("test.db");
+  remove("test.db.fsm");
+}
+
+TEST(DiskManagerTest, ReopenTest) {
+  char data[PAGE_SIZE];
+  memset(data, 0, PAGE_SIZE);
+  // without a free space map, the pages of the file are allocated
+  {
+    DiskManager disk_manager("test.db");
+    for (int i = 0; i < 5; ++i)
+      disk_manager.WritePage(disk_manager.AllocatePage(), data);
+  }
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_TRUE(disk_manager.IsAllocated(4));
+    EXPECT_EQ(5, disk_manager.AllocatePage());
+    // allocated, not written yet
+    EXPECT_EQ(6, disk_manager.AllocatePage());
+    disk_manager.DeallocatePage(2);
+    disk_manager.Sync();
+    // written after the map
+    disk_manager.WritePage(9, data);
+  }
+  // the map says where its pages end, the file has grown since
+  DiskManager disk_manager("test.db");
+  EXPECT_FALSE(disk_manager.IsAllocated(2));
+  EXPECT_TRUE(disk_manager.IsAllocated(6));
+  EXPECT_TRUE(disk_manager.IsAllocated(9));
+  EXPECT_EQ(1u, disk_manager.GetNumFreePages());
+  EXPECT_EQ(2, disk_manager.AllocatePage());
+  EXPECT_EQ(10, disk_manager.AllocatePage());
+
+  remove("test.db");
+  remove("test.db.fsm");
+}
+
+TEST(DiskManagerTest, ChecksumTest) {
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+  memset(data, 'a', PAGE_SIZE);
+  {
+    DiskManager disk_manager("test.db");
+    disk_manager.WritePage(0, data);
+    disk_manager.WritePage(1, data);
+  }
+  // the trailer holds the checksum, the rest is written as is
+  {
+    std::ifstream file("test.db", std::ios::binary);
+    file.read(buffer, PAGE_SIZE);
+  }
+  EXPECT_EQ(0, memcmp(data, buffer, PAGE_DATA_SIZE));
+  EXPECT_TRUE(DiskManager::VerifyChecksum(buffer));
+  buffer[100] ^= 1;
+  EXPECT_FALSE(DiskManager::VerifyChecksum(buffer));
+  memset(buffer, 0, PAGE_SIZE);
+  EXPECT_TRUE(DiskManager::VerifyChecksum(buffer));
+
+  // flip a bit of page 1 behind the DiskManager's back
+  {
+    std::fstream file("test.db",
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(PAGE_SIZE + 100);
+    file.put('a' ^ 1);
+  }
+  DiskManager disk_manager("test.db");
+  disk_manager.ReadPage(0, buffer);
+  try {
+    disk_manager.ReadPage(1, buffer);
+    ADD_FAILURE() << "corruption not detected";
+  } catch (PageCorruptionException &e) {
+    EXPECT_EQ(1, e.GetPageId());
+  }
+  std::vector<char> two_pages(2 * PAGE_SIZE);
+  EXPECT_THROW(disk_manager.ReadPages(0, 2, two_pages.data()),
+               PageCorruptionException);
+  EXPECT_FALSE(disk_manager.ReadPageAsync(1, buffer).get());
+  // rewritten, it passes again
+  disk_manager.WritePage(1, data);
+  EXPECT_TRUE(disk_manager.ReadPageAsync(1, buffer).get());
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  // half empty pages compress, random ones are stored as is
+  char data[PAGE_SIZE] = {};
+  char random[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+  for (int i = 0; i < PAGE_SIZE / 2; ++i)
+    data[i] = "tuple "[i % 6];
+  srand(0);
+  for (char &c : random)
+    c = static_cast<char>(rand());
+  struct stat stat_buf;
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_AUTO, DISK_IO_BUFFERED,
+                             DISK_COMPRESSION_LZ);
+    disk_manager.ReadPage(0, buffer);
+    EXPECT_EQ(0, buffer[0]);
+    for (int i = 0; i < 8; ++i)
+      disk_manager.WritePage(i, data);
+    disk_manager.WritePage(8, random);
+    EXPECT_EQ(9, disk_manager.GetNumPages());
+    // a slot each, and the whole random page
+    EXPECT_EQ(2 * PAGE_SIZE, disk_manager.GetStoredSize());
+    for (int i = 0; i < 9; ++i) {
+      disk_manager.ReadPage(i, buffer);
+      EXPECT_EQ(0, memcmp(i < 8 ? data : random, buffer, PAGE_DATA_SIZE));
+    }
+    std::vector<char> three_pages(3 * PAGE_SIZE);
+    disk_manager.ReadPages(7, 3, three_pages.data());
+    EXPECT_EQ(0, memcmp(data, three_pages.data(), PAGE_DATA_SIZE));
+    EXPECT_EQ(0, memcmp(random, three_pages.data() + PAGE_SIZE,
+                        PAGE_DATA_SIZE));
+    EXPECT_EQ(0, three_pages[2 * PAGE_SIZE]);
+
+    // page 0 moves, its slot is reused by page 10 after the Sync only
+    disk_manager.WritePage(0, random);
+    disk_manager.ReadPage(0, buffer);
+    EXPECT_EQ(0, memcmp(random, buffer, PAGE_DATA_SIZE));
+    disk_manager.WritePage(9, data);
+    ASSERT_EQ(0, stat("test.db", &stat_buf));
+    off_t size = stat_buf.st_size;
+    disk_manager.Sync();
+    disk_manager.WritePage(10, data);
+    ASSERT_EQ(0, stat("test.db", &stat_buf));
+    EXPECT_EQ(size, stat_buf.st_size);
+
+    // asynchronous, the pages are written one request each
+    const char *pages[] = {random, data};
+    EXPECT_TRUE(disk_manager.WritePagesAsync(11, pages, 2).get());
+    EXPECT_TRUE(disk_manager.ReadPageAsync(11, buffer).get());
+    EXPECT_EQ(0, memcmp(random, buffer, PAGE_DATA_SIZE));
+    EXPECT_TRUE(disk_manager.ReadPageAsync(12, buffer).get());
+    EXPECT_EQ(0, memcmp(data, buffer, PAGE_DATA_SIZE));
+
+    // a deallocated page gives its slots up
+    size_t stored_size = disk_manager.GetStoredSize();
+    for (int i = 0; i <= 8; ++i)
+      disk_manager.AllocatePage();
+    disk_manager.DeallocatePage(8);
+    EXPECT_EQ(stored_size - PAGE_SIZE, disk_manager.GetStoredSize());
+    disk_manager.ReadPage(8, buffer);
+    EXPECT_EQ(0, buffer[0]);
+  }
+  // reopened, the pages are found through the location map
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_AUTO, DISK_IO_BUFFERED,
+                             DISK_COMPRESSION_LZ);
+    EXPECT_EQ(13, disk_manager.GetNumPages());
+    disk_manager.ReadPage(0, buffer);
+    EXPECT_EQ(0, memcmp(random, buffer, PAGE_DATA_SIZE));
+    disk_manager.ReadPage(10, buffer);
+    EXPECT_EQ(0, memcmp(data, buffer, PAGE_DATA_SIZE));
+  }
+  // a file is opened the way it was written
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+  EXPECT_THROW(DiskManager("test.db", ASYNC_IO_AUTO, DISK_IO_MMAP,
+                           DISK_COMPRESSION_LZ),
+               Exception);
+
+  // damage the compressed bytes of page 10
+  {
+    std::fstream file("test.db",
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekg(4);
+    char c = file.get();
+    file.seekp(4);
+    file.put(c ^ 1);
+  }
+  {
+    DiskManager disk_manager("test.db", ASYNC_IO_AUTO, DISK_IO_BUFFERED,
+                             DISK_COMPRESSION_LZ);
+    EXPECT_THROW(disk_manager.ReadPage(10, buffer), PageCorruptionException);
+    EXPECT_FALSE(disk_manager.ReadPageAsync(10, buffer).get());
+    disk_manager.ReadPage(9, buffer);
+  }
+  remove("test.db");
+  remove("test.db.fsm");
+  remove("test.db.loc");
+
+  // an uncompressed file is not taken for a compressed one
+  {
+    DiskManager disk_manager("test.db");
+    disk_manager.WritePage(0, data);
+  }
+  EXPECT_THROW(DiskManager("test.db", ASYNC_IO_AUTO, DISK_IO_BUFFERED,
+                           DISK_COMPRESSION_LZ),
+               Exception);
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  // a file that does not consist of whole pages is refused
+  {
+    std::ofstream file("test.db", std::ios::binary);
+    file << "not a database";
+  }
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+  remove("test.db");
+  EXPECT_THROW(DiskManager("no_such_dir/test.db"), Exception);
+}
+
+} // namespace cmudb
@@ -0,0 +1,115 @@
+/**
+ * testing_replacer_util.h
+ *
+ * Synthetic page access traces and a small buffer pool simulator to replay
+ * them against any Replacer<int>. Frames are numbered 0..num_frames-1, the
+ * same way BufferPoolManager hands Page pointers of its frame array to its
+ * replacer.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+struct ReplayResult {
+  size_t hits = 0;
+  size_t misses = 0;
+  double ns_per_op = 0;
+
+  inline double HitRate() const {
+    return hits + misses == 0 ? 0 : static_cast<double>(hits) / (hits + misses);
+  }
+};
+
+// length accesses over pages [0, num_pages), page 0 being the most popular
+inline std::vector<int> ZipfianTrace(int num_pages, int length,
+                                     double theta = 0.99, int seed = 0) {
+  std::vector<double> cdf(num_pages);
+  double sum = 0;
+  for (int i = 0; i < num_pages; ++i) {
+    sum += 1.0 / std::pow(i + 1, theta);
+    cdf[i] = sum;
+  }
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> dist(0, sum);
+  std::vector<int> trace;
+  trace.reserve(length);
+  for (int i = 0; i < length; ++i) {
+    trace.push_back(static_cast<int>(
+        std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin()));
+  }
+  return trace;
+}
+
+// num_lookups zipfian accesses over a hot set [0, hot_pages), interrupted
+// every scan_interval accesses by a sequential scan of scan_pages pages that
+// are read exactly once each (page ids above the hot set)
+inline std::vector<int> ScanTrace(int hot_pages, int num_lookups,
+                                  int scan_interval, int scan_pages,
+                                  int seed = 0) {
+  std::vector<int> lookups = ZipfianTrace(hot_pages, num_lookups, 0.99, seed);
+  std::vector<int> trace;
+  int next_scan_page = hot_pages;
+  for (int i = 0; i < num_lookups; ++i) {
+    if (i > 0 && i % scan_interval == 0) {
+      for (int j = 0; j < scan_pages; ++j)
+        trace.push_back(next_scan_page++);
+    }
+    trace.push_back(lookups[i]);
+  }
+  return trace;
+}
+
+// replay trace through a pool of num_frames frames managed by replacer, every
+// access pins and immediately unpins its page. If given, frame_page is kept
+// up to date with the page each frame holds (for replacers that track page
+// ids)
+inline ReplayResult ReplayTrace(Replacer<int> &replacer, int num_frames,
+                                const std::vector<int> &trace,
+                                std::vector<int> *frame_page_out = nullptr) {
+  ReplayResult result;
+  std::unordered_map<int, int> page_table;
+  std::vector<int> local_frame_page;
+  std::vector<int> &frame_page =
+      frame_page_out != nullptr ? *frame_page_out : local_frame_page;
+  frame_page.assign(num_frames, -1);
+  int next_free_frame = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int page : trace) {
+    int frame;
+    auto it = page_table.find(page);
+    if (it != page_table.end()) {
+      frame = it->second;
+      replacer.Erase(frame);
+      result.hits++;
+    } else {
+      if (next_free_frame < num_frames) {
+        frame = next_free_frame++;
+      } else if (replacer.Victim(frame)) {
+        page_table.erase(frame_page[frame]);
+      } else {
+        continue;
+      }
+      frame_page[frame] = page;
+      page_table[page] = frame;
+      result.misses++;
+    }
+    replacer.Insert(frame);
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  result.ns_per_op = trace.empty() ? 0 : elapsed.count() / trace.size();
+  return result;
+}
+
+} // namespace cmudb
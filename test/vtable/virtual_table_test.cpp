@@ -1,6 +1,9 @@
 /**
  * virtual_table_test.cpp
  */
+#include <cstdint>
+#include <cstdlib>
+
 #include "vtable/testing_vtable_util.h"
 
 namespace cmudb {
@@ -44,4 +47,82 @@ TEST(VtableTest, CreateTest) {
   remove("vtable.db");
   return;
 }
+
+// first column of the first row of sql
+int64_t QueryInt(sqlite3 *db, std::string sql) {
+  sqlite3_stmt *stmt;
+  int64_t result = -1;
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    return result;
+  if (sqlite3_step(stmt) == SQLITE_ROW)
+    result = sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+  return result;
+}
+
+TEST(VtableTest, PoolSizeTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  setenv("VTABLE_POOL_SIZE", "16", 1);
+  setenv("VTABLE_MAX_POOL_SIZE", "64", 1);
+  sqlite3 *db;
+  EXPECT_EQ(SQLITE_OK, sqlite3_open(db_file.c_str(), &db));
+  EXPECT_EQ(SQLITE_OK, sqlite3_enable_load_extension(db, 1));
+  char *zErrMsg = 0;
+  EXPECT_EQ(SQLITE_OK, sqlite3_load_extension(db, "libvtable", 0, &zErrMsg));
+
+  // sized by the environment, resized online within the budget
+  EXPECT_EQ(16, QueryInt(db, "SELECT vtable_pool_size()"));
+  EXPECT_EQ(32, QueryInt(db, "SELECT vtable_pool_size(32)"));
+  EXPECT_FALSE(ExecSQL(db, "SELECT vtable_pool_size(65)"));
+  EXPECT_EQ(32, QueryInt(db, "SELECT vtable_pool_size()"));
+
+  // or by the module arguments
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable ('a INT, b "
+                          "int', 'foo2_pk a', pool_size=48)"));
+  EXPECT_EQ(48, QueryInt(db, "SELECT vtable_pool_size()"));
+  EXPECT_FALSE(ExecSQL(db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT', "
+                           "cache_size=8)"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(1, 2)"));
+  EXPECT_EQ(1, QueryInt(db, "SELECT count(*) FROM foo2"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo2"));
+
+  EXPECT_EQ(SQLITE_OK, sqlite3_close(db));
+  unsetenv("VTABLE_POOL_SIZE");
+  unsetenv("VTABLE_MAX_POOL_SIZE");
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, StatsTableTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  setenv("VTABLE_PAGE_HEAT", "1", 1);
+  sqlite3 *db;
+  EXPECT_EQ(SQLITE_OK, sqlite3_open(db_file.c_str(), &db));
+  EXPECT_EQ(SQLITE_OK, sqlite3_enable_load_extension(db, 1));
+  char *zErrMsg = 0;
+  EXPECT_EQ(SQLITE_OK, sqlite3_load_extension(db, "libvtable", 0, &zErrMsg));
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo4 USING vtable ('a INT, b "
+                          "int', 'foo4_pk a')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(1, 2)"));
+  EXPECT_EQ(1, QueryInt(db, "SELECT count(*) FROM foo4"));
+
+  // eponymous tables, no CREATE VIRTUAL TABLE needed
+  EXPECT_EQ(7, QueryInt(db, "SELECT count(*) FROM bpm_stats"));
+  EXPECT_LT(0, QueryInt(db, "SELECT value FROM bpm_stats WHERE name = 'hits'"));
+  EXPECT_LT(0, QueryInt(db, "SELECT count(*) FROM bpm_page_heat"));
+  EXPECT_FALSE(ExecSQL(db, "DELETE FROM bpm_stats"));
+  EXPECT_EQ(1, QueryInt(db, "SELECT vtable_page_heat()"));
+  EXPECT_EQ(0, QueryInt(db, "SELECT vtable_page_heat(0)"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo4"));
+
+  EXPECT_EQ(SQLITE_OK, sqlite3_close(db));
+  unsetenv("VTABLE_PAGE_HEAT");
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
 } // namespace cmudb